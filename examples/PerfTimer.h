@@ -0,0 +1,20 @@
+#pragma once
+
+#include <chrono>
+#include <functional>  // std::invoke
+
+// wall time of one call of f(args...)
+template <typename Time = std::chrono::microseconds,
+          typename Clock = std::chrono::high_resolution_clock>
+struct perf_timer {
+    template <typename F, typename... Args>
+    static Time duration(F&& f, Args... args) {
+        auto start = Clock::now();
+
+        std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+
+        auto end = Clock::now();
+
+        return std::chrono::duration_cast<Time>(end - start);
+    }
+};
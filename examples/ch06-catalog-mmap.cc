@@ -0,0 +1,306 @@
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>  // std::memcpy
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "ch06-dvd.h"
+
+// On-disk layout, native endianness, every section 8-byte aligned:
+//   file_header
+//   record[record_count]        fixed-size tagged union, tag is the dvd variant index
+//   Genre[genre_count]          Movie::genre arrays, back to back
+//   track_record[track_count]   Music::tracks arrays, back to back
+//   char[strings_size]          string arena, referenced by (offset, length)
+namespace catalog_format {
+
+constexpr char magic[8] = {'D', 'V', 'D', 'C', 'A', 'T', '0', '1'};
+
+struct str_ref {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct file_header {
+    char magic[8];
+    std::uint64_t record_count;
+    std::uint64_t genre_count;
+    std::uint64_t track_count;
+    std::uint64_t strings_size;
+};
+
+struct record {
+    std::uint32_t tag;
+    std::uint32_t length;  // Movie minutes
+    str_ref title;
+    str_ref text;          // Music::artist, Software::vendor
+    std::uint32_t first;   // first genre (Movie) or first track (Music)
+    std::uint32_t count;
+};
+
+struct track_record {
+    str_ref title;
+    std::uint32_t seconds;
+    std::uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable_v<Genre> && sizeof(Genre) == 4);
+static_assert(sizeof(file_header) % 8 == 0 && sizeof(record) % 8 == 0 && sizeof(track_record) % 8 == 0);
+
+constexpr std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t{7}; }
+
+// offsets, counts and lengths are stored as 32-bit, larger values are refused instead of wrapped
+template <typename N>
+std::uint32_t to_u32(N const n, char const* what) {
+    if (n < 0 || static_cast<std::uint64_t>(n) > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error(std::string("catalog ") + what + " does not fit 32 bits");
+    return static_cast<std::uint32_t>(n);
+}
+
+}  // namespace catalog_format
+
+void write_catalog(std::filesystem::path const& path, std::vector<dvd> const& dvds) {
+    using namespace catalog_format;
+
+    std::vector<record> records;
+    std::vector<Genre> genres;
+    std::vector<track_record> tracks;
+    std::string strings;
+    records.reserve(dvds.size());
+
+    auto add_string = [&strings](std::string const& s) {
+        str_ref ref{to_u32(strings.size(), "string offset"), to_u32(s.size(), "string length")};
+        strings += s;
+        return ref;
+    };
+
+    for (auto const& d : dvds) {
+        record r{};
+        r.tag = static_cast<std::uint32_t>(d.index());
+        std::visit([&](auto const& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            r.title = add_string(arg.title);
+            if constexpr (std::is_same_v<T, Movie>) {
+                r.length = to_u32(arg.length.count(), "movie length");
+                r.first = to_u32(genres.size(), "genre offset");
+                r.count = to_u32(arg.genre.size(), "genre count");
+                genres.insert(genres.end(), arg.genre.begin(), arg.genre.end());
+            } else if constexpr (std::is_same_v<T, Music>) {
+                r.text = add_string(arg.artist);
+                r.first = to_u32(tracks.size(), "track offset");
+                r.count = to_u32(arg.tracks.size(), "track count");
+                for (auto const& t : arg.tracks)
+                    tracks.push_back({add_string(t.title), to_u32(t.length.count(), "track length"), 0});
+            } else if constexpr (std::is_same_v<T, Software>) {
+                r.text = add_string(arg.vendor);
+            }
+        },
+                   d);
+        records.push_back(r);
+    }
+
+    file_header h{};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.record_count = records.size();
+    h.genre_count = genres.size();
+    h.track_count = tracks.size();
+    h.strings_size = strings.size();
+
+    std::ofstream ofile(path, std::ios::binary);
+    if (!ofile.is_open()) throw std::runtime_error("cannot open " + path.string());
+
+    char const zeros[8] = {};
+    auto write_section = [&](void const* data, std::uint64_t size) {
+        ofile.write(static_cast<char const*>(data), size);
+        ofile.write(zeros, align8(size) - size);
+    };
+    write_section(&h, sizeof(h));
+    write_section(records.data(), records.size() * sizeof(record));
+    write_section(genres.data(), genres.size() * sizeof(Genre));
+    write_section(tracks.data(), tracks.size() * sizeof(track_record));
+    write_section(strings.data(), strings.size());
+    if (!ofile) throw std::runtime_error("cannot write " + path.string());
+}
+
+// read-only mapping of a whole file
+class mapped_file {
+    void const* addr = MAP_FAILED;
+    size_t length = 0;
+
+   public:
+    explicit mapped_file(std::filesystem::path const& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open " + path.string());
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            length = static_cast<size_t>(st.st_size);
+            addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) throw std::runtime_error("cannot map " + path.string());
+    }
+    ~mapped_file() { ::munmap(const_cast<void*>(addr), length); }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    std::span<std::byte const> bytes() const { return {static_cast<std::byte const*>(addr), length}; }
+};
+
+// views over the mapping, the same members as Movie/Music/Software without owning anything
+struct track_view {
+    std::string_view title;
+    std::chrono::seconds length;
+};
+
+struct movie_view {
+    std::string_view title;
+    std::chrono::minutes length;
+    std::span<Genre const> genre;
+};
+
+struct music_view {
+    std::string_view title;
+    std::string_view artist;
+    std::span<catalog_format::track_record const> raw_tracks;
+    std::string_view strings;
+
+    // track titles are checked as they are read
+    auto tracks() const {
+        return raw_tracks | std::views::transform([s = strings](catalog_format::track_record const& t) {
+                   if (t.title.offset > s.size() || t.title.length > s.size() - t.title.offset)
+                       throw std::runtime_error("corrupted catalog");
+                   return track_view{s.substr(t.title.offset, t.title.length), std::chrono::seconds(t.seconds)};
+               });
+    }
+};
+
+struct software_view {
+    std::string_view title;
+    std::string_view vendor;
+};
+
+class catalog_view {
+    mapped_file file;
+    std::span<catalog_format::record const> records;
+    std::span<Genre const> genres;
+    std::span<catalog_format::track_record const> tracks;
+    std::string_view strings;
+
+    // count comes from the header: divide instead of multiplying, so a huge count cannot wrap around
+    template <typename T>
+    static std::span<T const> section(std::span<std::byte const> bytes, std::uint64_t& offset, std::uint64_t count) {
+        if (offset > bytes.size() || count > (bytes.size() - offset) / sizeof(T)) throw std::runtime_error("truncated catalog");
+        std::span<T const> s(reinterpret_cast<T const*>(bytes.data() + offset), count);
+        offset += catalog_format::align8(count * sizeof(T));
+        return s;
+    }
+
+    // records are checked when they are read, opening the catalog never touches them
+    static void check(bool const ok) {
+        if (!ok) throw std::runtime_error("corrupted catalog");
+    }
+
+    std::string_view str(catalog_format::str_ref r) const {
+        check(r.offset <= strings.size() && r.length <= strings.size() - r.offset);
+        return strings.substr(r.offset, r.length);
+    }
+
+    template <typename T>
+    static std::span<T const> slice(std::span<T const> all, catalog_format::record const& r) {
+        check(r.first <= all.size() && r.count <= all.size() - r.first);
+        return all.subspan(r.first, r.count);
+    }
+
+   public:
+    // validates the header and section sizes only, no per-record parsing
+    explicit catalog_view(std::filesystem::path const& path) : file(path) {
+        using namespace catalog_format;
+        auto bytes = file.bytes();
+        std::uint64_t offset = 0;
+        auto h = section<file_header>(bytes, offset, 1);
+        if (std::memcmp(h[0].magic, magic, sizeof(magic)) != 0) throw std::runtime_error("not a dvd catalog");
+
+        records = section<record>(bytes, offset, h[0].record_count);
+        genres = section<Genre>(bytes, offset, h[0].genre_count);
+        tracks = section<track_record>(bytes, offset, h[0].track_count);
+        auto chars = section<char>(bytes, offset, h[0].strings_size);
+        strings = std::string_view(chars.data(), chars.size());
+    }
+
+    size_t size() const { return records.size(); }
+
+    // same alternative order as dvd
+    size_t index(size_t const i) const {
+        check(records[i].tag <= 2);
+        return records[i].tag;
+    }
+    std::string_view title(size_t const i) const { return str(records[i].title); }
+
+    template <typename F>
+    decltype(auto) visit(size_t const i, F&& f) const {
+        auto const& r = records[i];
+        switch (index(i)) {
+            case 0:
+                return f(movie_view{str(r.title), std::chrono::minutes(r.length), slice(genres, r)});
+            case 1:
+                return f(music_view{str(r.title), str(r.text), slice(tracks, r), strings});
+            default:
+                return f(software_view{str(r.title), str(r.text)});
+        }
+    }
+};
+
+int main() {
+    using namespace std::chrono_literals;
+
+    std::vector<dvd> dvds{
+        Movie{"The Matrix", 2h + 16min, {Genre::Action, Genre::SF}},
+        Music{"The Wall", "Pink Floyd", {{"Mother", 5min + 32s}, {"Another Brick in the Wall", 9min + 8s}}},
+        Software{"Windows", "Microsoft"},
+    };
+
+    auto path = std::filesystem::temp_directory_path() / "dvds.cat";
+    write_catalog(path, dvds);
+
+    catalog_view catalog(path);
+    for (size_t i = 0; i < catalog.size(); ++i) {
+        catalog.visit(i, [](auto const& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, movie_view>) {
+                std::cout << "Movie" << '\n';
+                std::cout << "  Title: " << arg.title << '\n';
+                std::cout << "  Length: " << arg.length.count() << "min" << '\n';
+                std::cout << "  Genres: " << arg.genre.size() << '\n';
+            } else if constexpr (std::is_same_v<T, music_view>) {
+                std::cout << "Music" << '\n';
+                std::cout << "  Title: " << arg.title << '\n';
+                std::cout << "  Artist: " << arg.artist << '\n';
+                for (auto const& t : arg.tracks())
+                    std::cout << "    Track: " << t.title
+                              << ", " << t.length.count() << "sec" << '\n';
+            } else if constexpr (std::is_same_v<T, software_view>) {
+                std::cout << "Software" << '\n';
+                std::cout << "  Title: " << arg.title << '\n';
+                std::cout << "  Vendor: " << arg.vendor << '\n';
+            }
+        });
+    }
+
+    std::filesystem::remove(path);
+}
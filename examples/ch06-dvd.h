@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>  // std::transform
+#include <cctype>     // toupper
+#include <chrono>
+#include <string>
+#include <variant>
+#include <vector>
+
+// upper string
+template <typename CharT>
+using tstring = std::basic_string<CharT, std::char_traits<CharT>, std::allocator<CharT>>;
+
+template <typename CharT>
+inline tstring<CharT> to_upper(tstring<CharT> text) {
+    std::transform(std::begin(text), std::end(text), std::begin(text), toupper);
+    return text;
+}
+
+// upper string in place, no copy of the buffer
+template <typename CharT>
+inline void to_upper_inplace(tstring<CharT>& text) {
+    std::transform(std::begin(text), std::end(text), std::begin(text), toupper);
+}
+
+enum class Genre { Drama,
+                   Action,
+                   SF,
+                   Comedy };
+
+struct Movie {
+    std::string title;
+    std::chrono::minutes length;
+    std::vector<Genre> genre;
+};
+
+struct Track {
+    std::string title;
+    std::chrono::seconds length;
+};
+
+struct Music {
+    std::string title;
+    std::string artist;
+    std::vector<Track> tracks;
+};
+
+struct Software {
+    std::string title;
+    std::string vendor;
+};
+
+using dvd = std::variant<Movie, Music, Software>;
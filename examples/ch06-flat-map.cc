@@ -0,0 +1,333 @@
+#include <algorithm>  // std::stable_sort, std::unique
+#include <bit>        // std::countr_one
+#include <chrono>
+#include <cstdint>
+#include <functional>  // std::less, std::function
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>  // make_unique
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>  // std::pair
+#include <vector>
+
+#include "PerfTimer.h"
+
+// key extractors
+struct identity_key {
+    template <typename T>
+    T const& operator()(T const& v) const { return v; }
+};
+struct pair_first_key {
+    template <typename T>
+    auto const& operator()(T const& v) const { return v.first; }
+};
+
+// sorted contiguous storage, built once, then read only
+// small keys also get an Eytzinger (BFS ordered) copy, the first levels of the search tree share cache lines
+template <typename Value, typename Key, typename KeyOf, typename Compare>
+class flat_tree {
+   protected:
+    std::vector<Value> items;
+
+   private:
+    static constexpr bool use_eytzinger = std::is_arithmetic_v<Key> || std::is_pointer_v<Key>;
+
+    std::vector<Key> eyt;            // 1-based, eyt[0] unused
+    std::vector<std::uint32_t> rank;  // eytzinger slot -> index in items
+    [[no_unique_address]] Compare comp;
+
+    size_t build_eytzinger(size_t i, size_t const k) {
+        if (k <= items.size()) {
+            i = build_eytzinger(i, 2 * k);
+            eyt[k] = KeyOf{}(items[i]);
+            rank[k] = static_cast<std::uint32_t>(i++);
+            i = build_eytzinger(i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    void freeze() {
+        std::stable_sort(items.begin(), items.end(), [this](Value const& a, Value const& b) {
+            return comp(KeyOf{}(a), KeyOf{}(b));
+        });
+        // like std::map::insert, the first inserted of equal keys wins
+        auto last = std::unique(items.begin(), items.end(), [this](Value const& a, Value const& b) {
+            return !comp(KeyOf{}(a), KeyOf{}(b)) && !comp(KeyOf{}(b), KeyOf{}(a));
+        });
+        items.erase(last, items.end());
+        items.shrink_to_fit();
+
+        if constexpr (use_eytzinger) {
+            if (items.size() >= std::numeric_limits<std::uint32_t>::max())
+                throw std::length_error("flat_tree: too many items for 32-bit Eytzinger ranks");
+            eyt.assign(items.size() + 1, Key{});
+            rank.assign(items.size() + 1, 0);
+            build_eytzinger(0, 1);
+        }
+    }
+
+    template <typename K>
+    size_t lower_bound_index(K const& key) const {
+        auto const n = items.size();
+        if constexpr (use_eytzinger) {
+            size_t k = 1;
+            while (k <= n) {
+                __builtin_prefetch(eyt.data() + std::min(16 * k, n));
+                k = 2 * k + comp(eyt[k], key);
+            }
+            // undo the trailing right turns, plus the last left turn
+            k >>= std::countr_one(k) + 1;
+            return k == 0 ? n : rank[k];
+        } else {
+            // branchless binary search, the compiler emits a cmov instead of a jump
+            if (n == 0) return 0;
+            auto base = items.data();
+            auto len = n;
+            while (len > 1) {
+                auto half = len / 2;
+                base = comp(KeyOf{}(base[half - 1]), key) ? base + half : base;
+                len -= half;
+            }
+            return (base - items.data()) + comp(KeyOf{}(*base), key);
+        }
+    }
+
+   protected:
+    template <typename K>
+    size_t find_index(K const& key) const {
+        auto i = lower_bound_index(key);
+        if (i != items.size() && !comp(key, KeyOf{}(items[i]))) return i;
+        return items.size();
+    }
+
+   public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef typename std::vector<Value>::const_iterator constant_iterator;
+
+    // collects values unsorted, freeze() sorts once and hands over the storage
+    template <typename Tree>
+    class basic_builder {
+        std::vector<Value> pending;
+
+       public:
+        void reserve(size_t const n) { pending.reserve(n); }
+
+        template <typename... Args>
+        basic_builder& emplace(Args&&... args) {
+            pending.emplace_back(std::forward<Args>(args)...);
+            return *this;
+        }
+
+        Tree freeze() && { return Tree(std::move(pending)); }
+    };
+
+    flat_tree() = default;
+    explicit flat_tree(std::vector<Value>&& values) : items(std::move(values)) { freeze(); }
+    flat_tree(std::initializer_list<Value> init) : items(init) { freeze(); }
+    template <typename Iter>
+    flat_tree(Iter first, Iter last) : items(first, last) { freeze(); }
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+
+    // K is any type Compare can order against Key (heterogeneous lookup with std::less<>)
+    // only constant iterators: a changed key would break the order and the Eytzinger copy
+    template <typename K>
+    constant_iterator find(K const& key) const { return items.begin() + find_index(key); }
+    template <typename K>
+    constant_iterator lower_bound(K const& key) const { return items.begin() + lower_bound_index(key); }
+    template <typename K>
+    bool contains(K const& key) const { return find_index(key) != items.size(); }
+    template <typename K>
+    size_t count(K const& key) const { return contains(key) ? 1 : 0; }
+
+    constant_iterator begin() const { return items.begin(); }
+    constant_iterator end() const { return items.end(); }
+    constant_iterator cbegin() const { return items.cbegin(); }
+    constant_iterator cend() const { return items.cend(); }
+};
+
+// flat_map iterator with writable mapped values: it hands out (const key, value) pairs of references
+template <typename Key, typename T>
+class flat_map_iterator {
+    typedef typename std::vector<std::pair<Key, T>>::iterator base_iterator;
+    typedef typename std::vector<std::pair<Key, T>>::const_iterator constant_iterator;
+
+    base_iterator it;
+
+   public:
+    typedef flat_map_iterator self_type;
+    typedef std::pair<Key, T> value_type;
+    typedef std::pair<Key const&, T&> reference;
+    typedef ptrdiff_t difference_type;
+    typedef std::input_iterator_tag iterator_category;  // reference is not value_type&
+    typedef std::bidirectional_iterator_tag iterator_concept;
+
+    struct pointer {
+        reference ref;
+        reference const* operator->() const { return &ref; }
+    };
+
+    flat_map_iterator() = default;
+    explicit flat_map_iterator(base_iterator const it) : it(it) {}
+
+    reference operator*() const { return {it->first, it->second}; }
+    pointer operator->() const { return {**this}; }
+
+    self_type& operator++() {
+        ++it;
+        return *this;
+    }
+    self_type operator++(int) {
+        self_type tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    self_type& operator--() {
+        --it;
+        return *this;
+    }
+    self_type operator--(int) {
+        self_type tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    operator constant_iterator() const { return it; }
+    bool operator==(self_type const& other) const { return it == other.it; }
+    bool operator==(constant_iterator const& other) const { return it == other; }
+};
+
+template <typename Key, typename T, typename Compare = std::less<>>
+class flat_map : public flat_tree<std::pair<Key, T>, Key, pair_first_key, Compare> {
+    typedef flat_tree<std::pair<Key, T>, Key, pair_first_key, Compare> base_type;
+
+   public:
+    typedef T mapped_type;
+    typedef flat_map_iterator<Key, T> iterator;
+    typedef typename base_type::template basic_builder<flat_map> builder;
+
+    using base_type::base_type;
+    flat_map(std::initializer_list<std::pair<Key, T>> init) : base_type(init) {}
+
+    using base_type::find;
+    // keys are frozen, mapped values stay writable
+    template <typename K>
+    iterator find(K const& key) { return iterator(this->items.begin() + this->find_index(key)); }
+
+    template <typename K>
+    T& at(K const& key) {
+        auto i = this->find_index(key);
+        if (i != this->items.size()) return this->items[i].second;
+        throw std::out_of_range("key not found");
+    }
+    template <typename K>
+    T const& at(K const& key) const {
+        auto it = this->find(key);
+        if (it != this->end()) return it->second;
+        throw std::out_of_range("key not found");
+    }
+};
+
+template <typename Key, typename Compare = std::less<>>
+class flat_set : public flat_tree<Key, Key, identity_key, Compare> {
+    typedef flat_tree<Key, Key, identity_key, Compare> base_type;
+
+   public:
+    typedef typename base_type::template basic_builder<flat_set> builder;
+
+    using base_type::base_type;
+    flat_set(std::initializer_list<Key> init) : base_type(init) {}
+};
+
+class Image {
+   public:
+    virtual ~Image() = default;
+};
+class BitmapImage : public Image {};
+class PngImage : public Image {};
+class JpgImage : public Image {};
+
+void test_example1() {
+    // the factory registry of 11DesignPattern&Idiom.md, looked up by std::string_view without a temporary std::string
+    static flat_map<std::string, std::function<std::unique_ptr<Image>()>> const mapping{
+        {"bmp", []() { return std::make_unique<BitmapImage>(); }},
+        {"png", []() { return std::make_unique<PngImage>(); }},
+        {"jpg", []() { return std::make_unique<JpgImage>(); }}};
+
+    std::string_view type = "png";
+    if (auto it = mapping.find(type); it != mapping.end()) {
+        auto img = it->second();
+        std::cout << "created " << it->first << ": " << std::boolalpha << (img != nullptr) << '\n';
+    }
+    std::cout << mapping.contains("gif") << '\n';
+
+    // pointer keys take the Eytzinger path
+    flat_map<std::type_info const*, std::function<std::unique_ptr<Image>()>> by_type{
+        {&typeid(BitmapImage), []() { return std::make_unique<BitmapImage>(); }},
+        {&typeid(PngImage), []() { return std::make_unique<PngImage>(); }},
+        {&typeid(JpgImage), []() { return std::make_unique<JpgImage>(); }}};
+    std::cout << (by_type.at(&typeid(JpgImage))() != nullptr) << '\n';
+}
+
+void test_example2() {
+    // bulk build, then freeze: one sort instead of n tree insertions
+    flat_map<std::string, int>::builder b;
+    b.emplace("timeout", 30).emplace("retries", 3).emplace("port", 8080).emplace("timeout", 60);
+    auto config = std::move(b).freeze();
+    for (auto const& [k, v] : config) std::cout << k << '=' << v << ',';
+    std::cout << '\n';  // port=8080,retries=3,timeout=30,
+
+    if (auto it = config.find("retries"); it != config.end()) it->second = 5;  // it->first is const
+    std::cout << config.at("retries") << '\n';  // 5
+
+    try {
+        config.at("verbose");
+    } catch (std::out_of_range const& e) {
+        std::cout << e.what() << '\n';
+    }
+
+    flat_set<int> primes{7, 2, 5, 3, 11, 13, 2};
+    for (int i = 0; i < 15; ++i)
+        if (primes.contains(i)) std::cout << i << ',';
+    std::cout << '\n';
+}
+
+void test_example3() {
+    constexpr int n = 1'000'000;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist;
+    std::vector<int> keys(n);
+    for (auto& k : keys) k = dist(gen);
+
+    std::map<int, int> tree;
+    flat_map<int, int>::builder b;
+    b.reserve(n);
+    for (auto k : keys) {
+        tree.emplace(k, k);
+        b.emplace(k, k);
+    }
+    auto flat = std::move(b).freeze();
+
+    std::shuffle(keys.begin(), keys.end(), gen);
+    long long s1 = 0, s2 = 0;
+    auto t1 = perf_timer<>::duration([&] { for (auto k : keys) s1 += tree.find(k)->second; });
+    auto t2 = perf_timer<>::duration([&] { for (auto k : keys) s2 += flat.find(k)->second; });
+    std::cout << "std::map sum: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+    std::cout << "flat_map sum: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+}
+
+int main() {
+    test_example1();
+    test_example2();
+    test_example3();
+}
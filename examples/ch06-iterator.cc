@@ -1,5 +1,6 @@
 #include <algorithm>   // std::transform, std::for_each
 #include <cassert>     // assert()
+#include <cstdint>     // std::uint32_t
 #include <functional>  // bad_function_call()
 #include <iostream>
 #include <iterator>  // reverse_iterator
@@ -11,17 +12,17 @@ class dummy_array {
     Type data[Size] = {};
 
    public:
-    Type& operator[](size_t const i) {
+    constexpr Type& operator[](size_t const i) {
         if (i < Size) return data[i];
         throw std::out_of_range("index out of range");
     }
 
-    Type const& operator[](size_t const i) const {
+    constexpr Type const& operator[](size_t const i) const {
         if (i < Size) return data[i];
         throw std::out_of_range("index out of range");
     }
 
-    size_t size() const { return Size; }
+    constexpr size_t size() const { return Size; }
 
     template <typename T, size_t const SZ>
     class dummy_array_iterator {
@@ -36,13 +37,13 @@ class dummy_array {
         pointer ptr = nullptr;
         size_t index = 0;
 
-        bool compatible(self_type const& other) const {
+        constexpr bool compatible(self_type const& other) const {
             return ptr == other.ptr;
         }
 
        public:
         // ctor with inputs
-        explicit dummy_array_iterator(pointer ptr, size_t const index) : ptr(ptr), index(index) {
+        constexpr explicit dummy_array_iterator(pointer ptr, size_t const index) : ptr(ptr), index(index) {
         }
         // default ctor
         dummy_array_iterator() = default;
@@ -54,93 +55,94 @@ class dummy_array {
         ~dummy_array_iterator() = default;
 
         // prefix ++
-        self_type& operator++() {
+        constexpr self_type& operator++() {
             if (index >= SZ)
                 throw std::out_of_range("Iterator cannot be incremented past the end of range.");
             ++index;
             return *this;
         }
         // postfix ++
-        self_type operator++(int) {
+        constexpr self_type operator++(int) {
             self_type tmp = *this;
             ++*this;
             return tmp;
         }
         // prefix --
-        self_type& operator--() {
+        constexpr self_type& operator--() {
             if (index <= 0)
                 throw std::out_of_range("Iterator cannot be decremented past the end of range.");
             --index;
             return *this;
         }
         // postfix --
-        self_type operator--(int) {
+        constexpr self_type operator--(int) {
             self_type tmp = *this;
             --*this;
             return tmp;
         }
         // comparisons
-        bool operator==(self_type const& other) const {
+        constexpr bool operator==(self_type const& other) const {
             assert(compatible(other));
             return index == other.index;
         }
-        bool operator!=(self_type const& other) const {
+        constexpr bool operator!=(self_type const& other) const {
             return !(*this == other);
         }
-        bool operator<(self_type const& other) const {
+        constexpr bool operator<(self_type const& other) const {
             assert(compatible(other));
             return index < other.index;
         }
-        bool operator>(self_type const& other) const {
+        constexpr bool operator>(self_type const& other) const {
             return other < *this;
         }
-        bool operator<=(self_type const& other) const {
+        constexpr bool operator<=(self_type const& other) const {
             return !(*this > other);
         }
-        bool operator>=(self_type const& other) const {
+        constexpr bool operator>=(self_type const& other) const {
             return !(*this < other);
         }
 
         // can be dereferenced as an rvalue
-        reference operator*() const {
+        constexpr reference operator*() const {
             if (ptr == nullptr)
                 throw std::bad_function_call();
             return *(ptr + index);
         }
-        reference operator->() const {
+        constexpr reference operator->() const {
             if (ptr == nullptr)
                 throw std::bad_function_call();
             return *(ptr + index);
         }
 
         // offset
-        self_type& operator+=(difference_type const offset) {
-            if (index + offset < 0 || index + offset > SZ)
+        constexpr self_type& operator+=(difference_type const offset) {
+            auto const next = static_cast<difference_type>(index) + offset;
+            if (next < 0 || next > static_cast<difference_type>(SZ))
                 throw std::out_of_range("Iterator cannot be incremented past the end of range.");
 
-            index += offset;
+            index = static_cast<size_t>(next);
             return *this;
         }
-        self_type& operator-=(difference_type const offset) {
+        constexpr self_type& operator-=(difference_type const offset) {
             return *this += -offset;
         }
-        self_type operator+(difference_type offset) const {
+        constexpr self_type operator+(difference_type offset) const {
             self_type tmp = *this;
             return tmp += offset;
         }
-        self_type operator-(difference_type offset) const {
+        constexpr self_type operator-(difference_type offset) const {
             self_type tmp = *this;
             return tmp -= offset;
         }
-        difference_type operator-(self_type const& other) const {
+        constexpr difference_type operator-(self_type const& other) const {
             assert(compatible(other));
             return (index - other.index);
         }
         // offset dereference operator ([])
-        value_type& operator[](difference_type const offset) {
+        constexpr value_type& operator[](difference_type const offset) {
             return (*(*this + offset));
         }
-        value_type const& operator[](difference_type const offset) const {
+        constexpr value_type const& operator[](difference_type const offset) const {
             return (*(*this + offset));
         }
     };
@@ -151,32 +153,42 @@ class dummy_array {
     typedef std::reverse_iterator<constant_iterator> reverse_constant_iterator;
 
    public:
-    iterator begin() {
+    constexpr iterator begin() {
         return iterator(data, 0);
     }
-    iterator end() {
+    constexpr iterator end() {
         return iterator(data, Size);
     }
-    constant_iterator begin() const {
+    constexpr constant_iterator begin() const {
         return constant_iterator(data, 0);
     }
-    constant_iterator end() const {
+    constexpr constant_iterator end() const {
         return constant_iterator(data, Size);
     }
-    constant_iterator cbegin() const {
+    constexpr constant_iterator cbegin() const {
         return constant_iterator(data, 0);
     }
-    constant_iterator cend() const {
+    constexpr constant_iterator cend() const {
         return constant_iterator(data, Size);
     }
-    reverse_iterator rbegin() {
+    constexpr reverse_iterator rbegin() {
         return reverse_iterator(end());
     }
-    reverse_iterator rend() {
+    constexpr reverse_iterator rend() {
         return reverse_iterator(begin());
     }
 };
 
+// fill a table from generator(i) at compile time, the result lives in .rodata
+template <size_t N, typename F>
+constexpr auto make_table(F&& generator) {
+    dummy_array<std::invoke_result_t<F&, size_t>, N> table;
+    for (size_t i = 0; i < N; ++i) {
+        table[i] = generator(i);
+    }
+    return table;
+}
+
 template <typename T, const size_t SZ>
 void print_dummy_array(dummy_array<T, SZ> const& arr) {
     for (auto& e : arr) {
@@ -288,6 +300,66 @@ void test_example6() {
     std::cout << '\n';
 }
 
+// lookup tables computed by the compiler
+constexpr auto crc32_table = make_table<256>([](size_t i) {
+    auto c = static_cast<std::uint32_t>(i);
+    for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    return c;
+});
+
+constexpr auto hex_table = make_table<16>([](size_t i) { return "0123456789abcdef"[i]; });
+
+enum char_class : unsigned char {
+    cc_none = 0,
+    cc_digit = 1,
+    cc_alpha = 2,
+    cc_space = 4
+};
+
+constexpr auto class_table = make_table<256>([](size_t c) {
+    unsigned char cls = cc_none;
+    if (c >= '0' && c <= '9') cls |= cc_digit;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) cls |= cc_alpha;
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') cls |= cc_space;
+    return cls;
+});
+
+constexpr std::uint32_t crc32(char const* s, size_t n) {
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i) {
+        c = crc32_table[(c ^ static_cast<unsigned char>(s[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+static_assert(crc32_table[1] == 0x77073096u);
+static_assert(crc32("123456789", 9) == 0xCBF43926u);
+static_assert(hex_table[10] == 'a');
+static_assert(class_table['7'] == cc_digit && class_table[' '] == cc_space);
+
+constexpr int sum_of_squares() {
+    auto table = make_table<10>([](size_t i) { return static_cast<int>(i * i); });
+    int sum = 0;
+    for (auto e : table) sum += e;                                   // iterators in constant evaluation
+    for (auto it = table.rbegin(); it != table.rend(); ++it) sum += *it;  // reverse too
+    return sum / 2;
+}
+static_assert(sum_of_squares() == 285);
+
+void test_example7() {
+    unsigned char byte = 0xB7;
+    std::cout << hex_table[byte >> 4] << hex_table[byte & 0xF] << '\n';
+    std::cout << std::hex << crc32("hello", 5) << std::dec << '\n';
+
+    int digits = 0;
+    for (auto c : std::string("room 101, floor 7")) {
+        if (class_table[static_cast<unsigned char>(c)] & cc_digit) ++digits;
+    }
+    std::cout << "digits: " << digits << '\n';
+}
+
 int main() {
     test_example1();
     test_example2();
@@ -295,4 +367,5 @@ int main() {
     test_example4();
     test_example5();
     test_example6();
+    test_example7();
 }
\ No newline at end of file
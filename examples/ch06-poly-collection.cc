@@ -0,0 +1,147 @@
+#include <chrono>
+#include <functional>  // std::invoke
+#include <iostream>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "ch06-dvd.h"
+#include "PerfTimer.h"
+
+template <typename... Ts>
+struct overloaded : Ts... {
+    using Ts::operator()...;
+};
+
+// one contiguous segment per alternative, no per-element tag and no padding to the largest type
+template <typename... Ts>
+class poly_collection {
+    std::tuple<std::vector<Ts>...> segments;
+
+   public:
+    typedef std::variant<Ts...> variant_type;
+
+    poly_collection() = default;
+
+    // the only dispatch is at insertion
+    template <typename Iter>
+    poly_collection(Iter first, Iter last) {
+        for (; first != last; ++first) insert(*first);
+    }
+
+    template <typename T>
+        requires(std::is_same_v<std::decay_t<T>, Ts> || ...)
+    void insert(T&& value) {
+        segment<std::decay_t<T>>().push_back(std::forward<T>(value));
+    }
+
+    void insert(variant_type const& v) {
+        std::visit([this](auto const& arg) { insert(arg); }, v);
+    }
+    void insert(variant_type&& v) {
+        std::visit([this](auto&& arg) { insert(std::move(arg)); }, std::move(v));
+    }
+
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        return segment<T>().emplace_back(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    std::vector<T>& segment() { return std::get<std::vector<T>>(segments); }
+    template <typename T>
+    std::vector<T> const& segment() const { return std::get<std::vector<T>>(segments); }
+
+    size_t size() const {
+        return std::apply([](auto const&... seg) { return (seg.size() + ...); }, segments);
+    }
+    template <typename T>
+    size_t size() const { return segment<T>().size(); }
+
+    void clear() {
+        std::apply([](auto&... seg) { (seg.clear(), ...); }, segments);
+    }
+
+    // the type is resolved once per segment, the inner loop calls f on a concrete type
+    template <typename F>
+    void for_each(F&& f) {
+        std::apply([&](auto&... seg) { (for_each_in(seg, f), ...); }, segments);
+    }
+    template <typename F>
+    void for_each(F&& f) const {
+        std::apply([&](auto const&... seg) { (for_each_in(seg, f), ...); }, segments);
+    }
+
+    // visit only one alternative
+    template <typename T, typename F>
+    void for_each(F&& f) {
+        for_each_in(segment<T>(), f);
+    }
+
+   private:
+    template <typename Seg, typename F>
+    static void for_each_in(Seg& seg, F& f) {
+        for (auto& e : seg) std::invoke(f, e);
+    }
+};
+
+using catalog = poly_collection<Movie, Music, Software>;
+
+int main() {
+    using namespace std::chrono_literals;
+
+    std::vector<dvd> dvds{
+        Movie{"The Matrix", 2h + 16min, {Genre::Action, Genre::SF}},
+        Music{"The Wall", "Pink Floyd", {{"Mother", 5min + 32s}, {"Another Brick in the Wall", 9min + 8s}}},
+        Software{"Windows", "Microsoft"},
+        Movie{"Alien", 1h + 57min, {Genre::SF}},
+    };
+
+    // example1: same output as the void visitor, ordered by type instead of insertion
+    {
+        catalog c(dvds.begin(), dvds.end());
+        c.for_each([](auto const& arg) { std::cout << arg.title << '\n'; });
+
+        c.for_each(overloaded{
+            [](Movie const& m) { std::cout << "Movie " << m.title << ", " << m.length.count() << "min\n"; },
+            [](Music const& m) { std::cout << "Music " << m.title << ", " << m.tracks.size() << " tracks\n"; },
+            [](Software const& s) { std::cout << "Software " << s.title << ", " << s.vendor << '\n'; }});
+
+        c.emplace<Software>("Linux", "Linus");
+        c.for_each<Software>([](Software& s) { s.vendor = to_upper(s.vendor); });
+        for (auto const& s : c.segment<Software>()) std::cout << s.title << ':' << s.vendor << '\n';
+        std::cout << "total: " << c.size() << ", movies: " << c.size<Movie>() << '\n';
+    }
+    // example2: sum of lengths, std::visit per element vs segment by segment
+    {
+        constexpr int n = 1'000'000;
+        std::vector<dvd> many;
+        many.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            switch (i % 3) {
+                case 0: many.emplace_back(Movie{"m", std::chrono::minutes(i % 200), {}}); break;
+                case 1: many.emplace_back(Music{"a", "b", {{"t", std::chrono::seconds(i % 300)}}}); break;
+                default: many.emplace_back(Software{"s", "v"}); break;
+            }
+        }
+        catalog c(many.begin(), many.end());
+
+        auto length = overloaded{
+            [](Movie const& m) -> long long { return std::chrono::seconds(m.length).count(); },
+            [](Music const& m) -> long long {
+                long long s = 0;
+                for (auto const& t : m.tracks) s += t.length.count();
+                return s;
+            },
+            [](Software const&) -> long long { return 0; }};
+
+        long long s1 = 0, s2 = 0;
+        auto t1 = perf_timer<>::duration([&] { for (auto const& d : many) s1 += std::visit(length, d); });
+        auto t2 = perf_timer<>::duration([&] { c.for_each([&](auto const& arg) { s2 += length(arg); }); });
+        std::cout << "sizeof(dvd): " << sizeof(dvd) << ", sizeof(Software): " << sizeof(Software) << '\n';
+        std::cout << "   std::visit sum: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "poly_collection sum: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+}
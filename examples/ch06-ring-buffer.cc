@@ -0,0 +1,371 @@
+#include <algorithm>  // std::copy
+#include <cassert>    // assert()
+#include <cstddef>
+#include <functional>  // std::less, std::greater
+#include <iostream>
+#include <iterator>  // reverse_iterator
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+// rolling-window hooks: called by ring_buffer on every push and eviction
+template <typename T>
+class rolling_sum {
+    T total{};
+
+   public:
+    void on_push(T const& v) { total += v; }
+    void on_evict(T const& v) { total -= v; }
+    void on_clear() { total = T{}; }
+    T value() const { return total; }
+};
+
+// monotonic queue of at most N values, front is the extremum of the window;
+// N must be a power of two and at least the size of the ring_buffer it is attached to
+template <typename T, size_t N, typename Compare>
+class rolling_extremum {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "rolling_extremum size must be a power of two");
+
+    T queue[N] = {};
+    size_t head = 0;
+    size_t tail = 0;
+    static constexpr size_t mask = N - 1;
+
+   public:
+    static constexpr size_t window = N;  // the largest ring_buffer it can follow
+
+    void on_push(T const& v) {
+        // keep equal values, so that evicting one duplicate leaves the other
+        while (head != tail && Compare{}(v, queue[(tail - 1) & mask])) --tail;
+        queue[tail++ & mask] = v;
+    }
+    void on_evict(T const& v) {
+        if (head != tail && !Compare{}(v, queue[head & mask]) && !Compare{}(queue[head & mask], v)) ++head;
+    }
+    void on_clear() { head = tail = 0; }
+    T value() const {
+        assert(head != tail);
+        return queue[head & mask];
+    }
+};
+
+template <typename T, size_t N>
+using rolling_min = rolling_extremum<T, N, std::less<>>;
+template <typename T, size_t N>
+using rolling_max = rolling_extremum<T, N, std::greater<>>;
+
+// hooks with a bounded window must hold the whole buffer, hooks without one hold a summary
+template <typename Hook, size_t Size>
+constexpr bool hook_fits() {
+    if constexpr (requires { Hook::window; })
+        return Hook::window >= Size;
+    else
+        return true;
+}
+
+// With hooks attached only const access is offered: writing through operator[], an iterator
+// or std::sort would change the window behind the hooks' back.
+template <typename Type, size_t const Size, typename... Hooks>
+class ring_buffer {
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "ring_buffer size must be a power of two");
+    static_assert((hook_fits<Hooks, Size>() && ...), "a rolling hook is smaller than the ring_buffer");
+    static constexpr bool writable = sizeof...(Hooks) == 0;
+    static constexpr size_t mask = Size - 1;
+
+    Type data[Size] = {};
+    // head/tail are monotonic counters, only masked on access
+    size_t head = 0;
+    size_t tail = 0;
+    std::tuple<Hooks...> hooks;
+
+    void notify_push(Type const& v) { std::apply([&](auto&... h) { (h.on_push(v), ...); }, hooks); }
+    void notify_evict(Type const& v) { std::apply([&](auto&... h) { (h.on_evict(v), ...); }, hooks); }
+
+   public:
+    // logical index: 0 is the oldest element
+    Type& operator[](size_t const i) requires writable { return data[(head + i) & mask]; }
+    Type const& operator[](size_t const i) const { return data[(head + i) & mask]; }
+
+    Type& at(size_t const i) requires writable {
+        if (i < size()) return (*this)[i];
+        throw std::out_of_range("index out of range");
+    }
+    Type const& at(size_t const i) const {
+        if (i < size()) return (*this)[i];
+        throw std::out_of_range("index out of range");
+    }
+
+    Type& front() requires writable { return data[head & mask]; }
+    Type const& front() const { return data[head & mask]; }
+    Type& back() requires writable { return data[(tail - 1) & mask]; }
+    Type const& back() const { return data[(tail - 1) & mask]; }
+
+    size_t size() const { return tail - head; }
+    constexpr size_t capacity() const { return Size; }
+    bool empty() const { return head == tail; }
+    bool full() const { return size() == Size; }
+
+    template <typename H>
+    H const& hook() const { return std::get<H>(hooks); }
+
+    // push a value, overwriting the oldest one when full
+    void push(Type const& v) {
+        if (full()) pop();
+        data[tail++ & mask] = v;
+        notify_push(v);
+    }
+
+    // push only if there is room left
+    bool try_push(Type const& v) {
+        if (full()) return false;
+        data[tail++ & mask] = v;
+        notify_push(v);
+        return true;
+    }
+
+    void pop() {
+        assert(!empty());
+        notify_evict(data[head & mask]);
+        ++head;
+    }
+
+    void clear() {
+        head = tail = 0;
+        std::apply([](auto&... h) { (h.on_clear(), ...); }, hooks);
+    }
+
+    // batch push with overwrite, only the last Size values of the range survive
+    template <typename Iter>
+    void push(Iter first, Iter last) {
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (count >= Size) {
+            clear();
+            std::advance(first, count - Size);
+            count = Size;
+        }
+
+        if constexpr (sizeof...(Hooks) == 0) {
+            // evict without looking at the values, then copy at most two contiguous segments
+            auto overflow = size() + count > Size ? size() + count - Size : 0;
+            head += overflow;
+            auto start = tail & mask;
+            auto first_part = std::min(count, Size - start);
+            auto mid = std::next(first, first_part);
+            std::copy(first, mid, data + start);
+            std::copy(mid, last, data);
+            tail += count;
+        } else {
+            for (; first != last; ++first) push(*first);
+        }
+    }
+
+    template <typename T>
+    class ring_buffer_iterator {
+       public:
+        typedef ring_buffer_iterator self_type;
+        typedef std::remove_const_t<T> value_type;
+        typedef T& reference;
+        typedef T* pointer;
+        typedef ptrdiff_t difference_type;
+        typedef std::random_access_iterator_tag iterator_category;
+
+       private:
+        pointer ptr = nullptr;
+        size_t pos = 0;
+
+        template <typename U>
+        friend class ring_buffer_iterator;
+
+        bool compatible(self_type const& other) const {
+            return ptr == other.ptr;
+        }
+
+       public:
+        // ctor with inputs
+        explicit ring_buffer_iterator(pointer ptr, size_t const pos) : ptr(ptr), pos(pos) {
+        }
+        // default ctor
+        ring_buffer_iterator() = default;
+        // iterator to constant_iterator
+        template <typename U>
+            requires(std::is_const_v<T> && std::is_same_v<U const, T> && !std::is_const_v<U>)
+        ring_buffer_iterator(ring_buffer_iterator<U> const& other) : ptr(other.ptr), pos(other.pos) {
+        }
+
+        // prefix ++
+        self_type& operator++() {
+            ++pos;
+            return *this;
+        }
+        // postfix ++
+        self_type operator++(int) {
+            self_type tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        // prefix --
+        self_type& operator--() {
+            --pos;
+            return *this;
+        }
+        // postfix --
+        self_type operator--(int) {
+            self_type tmp = *this;
+            --*this;
+            return tmp;
+        }
+        // comparisons
+        bool operator==(self_type const& other) const {
+            assert(compatible(other));
+            return pos == other.pos;
+        }
+        bool operator!=(self_type const& other) const {
+            return !(*this == other);
+        }
+        bool operator<(self_type const& other) const {
+            assert(compatible(other));
+            return static_cast<difference_type>(pos - other.pos) < 0;
+        }
+        bool operator>(self_type const& other) const {
+            return other < *this;
+        }
+        bool operator<=(self_type const& other) const {
+            return !(*this > other);
+        }
+        bool operator>=(self_type const& other) const {
+            return !(*this < other);
+        }
+
+        reference operator*() const {
+            return ptr[pos & mask];
+        }
+        pointer operator->() const {
+            return ptr + (pos & mask);
+        }
+
+        // offset
+        self_type& operator+=(difference_type const offset) {
+            pos += offset;
+            return *this;
+        }
+        self_type& operator-=(difference_type const offset) {
+            return *this += -offset;
+        }
+        self_type operator+(difference_type offset) const {
+            self_type tmp = *this;
+            return tmp += offset;
+        }
+        friend self_type operator+(difference_type offset, self_type const& it) {
+            return it + offset;
+        }
+        self_type operator-(difference_type offset) const {
+            self_type tmp = *this;
+            return tmp -= offset;
+        }
+        difference_type operator-(self_type const& other) const {
+            assert(compatible(other));
+            return static_cast<difference_type>(pos - other.pos);
+        }
+        // offset dereference operator ([])
+        reference operator[](difference_type const offset) const {
+            return *(*this + offset);
+        }
+    };
+
+    typedef ring_buffer_iterator<Type> iterator;
+    typedef ring_buffer_iterator<Type const> constant_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<constant_iterator> reverse_constant_iterator;
+
+   public:
+    iterator begin() requires writable {
+        return iterator(data, head);
+    }
+    iterator end() requires writable {
+        return iterator(data, tail);
+    }
+    constant_iterator begin() const {
+        return constant_iterator(data, head);
+    }
+    constant_iterator end() const {
+        return constant_iterator(data, tail);
+    }
+    constant_iterator cbegin() const {
+        return constant_iterator(data, head);
+    }
+    constant_iterator cend() const {
+        return constant_iterator(data, tail);
+    }
+    reverse_iterator rbegin() requires writable {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() requires writable {
+        return reverse_iterator(begin());
+    }
+    reverse_constant_iterator rbegin() const {
+        return reverse_constant_iterator(end());
+    }
+    reverse_constant_iterator rend() const {
+        return reverse_constant_iterator(begin());
+    }
+};
+
+template <typename T, size_t SZ, typename... Hooks>
+void print_ring_buffer(ring_buffer<T, SZ, Hooks...> const& rb) {
+    for (auto& e : rb) {
+        std::cout << e << ',';
+    }
+    std::cout << '\n';
+}
+
+void test_example1() {
+    ring_buffer<int, 4> rb;
+    for (int i = 1; i <= 6; ++i) rb.push(i);
+    print_ring_buffer(rb);  // 3,4,5,6,
+    for (auto it = rb.rbegin(); it != rb.rend(); ++it) {
+        std::cout << *it << ',';
+    }
+    std::cout << '\n';  // 6,5,4,3,
+
+    std::sort(rb.begin(), rb.end(), std::greater<>());
+    print_ring_buffer(rb);  // 6,5,4,3,
+    std::cout << rb.front() << ' ' << rb.back() << ' ' << rb[1] << '\n';
+
+    ring_buffer<int, 4>::constant_iterator first = rb.begin();
+    std::cout << (first == rb.cbegin()) << ' ' << (rb.cend() - first) << '\n';  // 1 4
+}
+
+void test_example2() {
+    // batch push wraps around the end of the storage
+    ring_buffer<int, 8> rb;
+    int a[] = {1, 2, 3, 4, 5, 6};
+    int b[] = {7, 8, 9, 10, 11};
+    rb.push(std::begin(a), std::end(a));
+    rb.push(std::begin(b), std::end(b));
+    print_ring_buffer(rb);  // 4,5,6,7,8,9,10,11,
+
+    int c[] = {21, 22, 23, 24, 25, 26, 27, 28, 29, 30};
+    rb.push(std::begin(c), std::end(c));
+    print_ring_buffer(rb);  // 23,...,30,
+    std::cout << std::boolalpha << rb.try_push(31) << '\n';  // false
+}
+
+void test_example3() {
+    // rolling window over a price series, replaces std::deque<double>
+    using window = ring_buffer<double, 4, rolling_sum<double>, rolling_min<double, 4>, rolling_max<double, 4>>;
+    window w;
+    double prices[] = {10.1, 10.4, 9.8, 10.0, 10.7, 10.2, 9.5, 9.9};
+    for (auto p : prices) {
+        w.push(p);
+        std::cout << "price=" << p
+                  << ", mean=" << w.hook<rolling_sum<double>>().value() / w.size()
+                  << ", min=" << w.hook<rolling_min<double, 4>>().value()
+                  << ", max=" << w.hook<rolling_max<double, 4>>().value() << '\n';
+    }
+}
+
+int main() {
+    test_example1();
+    test_example2();
+    test_example3();
+}
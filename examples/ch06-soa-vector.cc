@@ -0,0 +1,320 @@
+#include <algorithm>  // std::sort, std::count_if
+#include <cassert>    // assert()
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // std::index_sequence
+#include <vector>
+
+// proxy reference to one row of a soa_vector, assignments write through to the columns.
+// An rvalue row is moved from, column by column: that is what std::sort's *a = std::move(*b) and
+// value_type tmp = std::move(*b) need to move the strings instead of copying them. The prvalue of
+// *it or v[i] counts as an rvalue too, so copy a row through a named proxy: auto r = v[j]; v[i] = r;
+template <typename... Ts>
+class soa_ref {
+    std::tuple<Ts&...> refs;
+
+    template <typename Tuple, size_t... I>
+    void assign(Tuple&& t, std::index_sequence<I...>) const {
+        ((std::get<I>(refs) = std::get<I>(std::forward<Tuple>(t))), ...);
+    }
+
+    std::tuple<Ts&&...> moved() const {
+        return std::apply([](auto&... r) { return std::tuple<Ts&&...>(std::move(r)...); }, refs);
+    }
+
+   public:
+    typedef std::tuple<std::remove_const_t<Ts>...> value_type;
+
+    explicit soa_ref(Ts&... r) : refs(r...) {}
+    soa_ref(soa_ref const&) = default;
+
+    // const qualified: a proxy returned by value is still assignable
+    soa_ref const& operator=(soa_ref const& other) const {
+        assign(other.refs, std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+    soa_ref& operator=(soa_ref const& other) {
+        assign(other.refs, std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+    soa_ref const& operator=(soa_ref&& other) const {
+        assign(other.moved(), std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+    soa_ref& operator=(soa_ref&& other) {
+        assign(other.moved(), std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+    soa_ref const& operator=(value_type const& v) const {
+        assign(v, std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+    soa_ref const& operator=(value_type&& v) const {
+        assign(std::move(v), std::index_sequence_for<Ts...>{});
+        return *this;
+    }
+
+    operator value_type() const& { return value_type(refs); }
+    operator value_type() && { return value_type(moved()); }
+
+    template <size_t I>
+    friend decltype(auto) get(soa_ref const& r) { return std::get<I>(r.refs); }
+
+    friend void swap(soa_ref a, soa_ref b) {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            using std::swap;
+            (swap(std::get<I>(a.refs), std::get<I>(b.refs)), ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+};
+
+// a proxy and its value type meet at the value type, required by std::indirectly_readable
+template <typename... Ts, typename... Us, template <typename> class TQual, template <typename> class UQual>
+struct std::basic_common_reference<soa_ref<Ts...>, std::tuple<Us...>, TQual, UQual> {
+    using type = std::tuple<Us...>;
+};
+template <typename... Us, typename... Ts, template <typename> class TQual, template <typename> class UQual>
+struct std::basic_common_reference<std::tuple<Us...>, soa_ref<Ts...>, TQual, UQual> {
+    using type = std::tuple<Us...>;
+};
+
+// zip iterator over the columns
+template <typename... Ts>
+class soa_iterator {
+   public:
+    typedef soa_iterator self_type;
+    typedef std::tuple<std::remove_const_t<Ts>...> value_type;
+    typedef soa_ref<Ts...> reference;
+    typedef void pointer;
+    typedef ptrdiff_t difference_type;
+    typedef std::random_access_iterator_tag iterator_category;
+
+   private:
+    std::tuple<Ts*...> ptrs;
+    difference_type index = 0;
+
+   public:
+    // ctor with inputs
+    explicit soa_iterator(std::tuple<Ts*...> ptrs, difference_type const index) : ptrs(ptrs), index(index) {
+    }
+    // default ctor
+    soa_iterator() = default;
+
+    // prefix ++
+    self_type& operator++() {
+        ++index;
+        return *this;
+    }
+    // postfix ++
+    self_type operator++(int) {
+        self_type tmp = *this;
+        ++*this;
+        return tmp;
+    }
+    // prefix --
+    self_type& operator--() {
+        --index;
+        return *this;
+    }
+    // postfix --
+    self_type operator--(int) {
+        self_type tmp = *this;
+        --*this;
+        return tmp;
+    }
+    // comparisons
+    bool operator==(self_type const& other) const {
+        assert(ptrs == other.ptrs);
+        return index == other.index;
+    }
+    auto operator<=>(self_type const& other) const {
+        assert(ptrs == other.ptrs);
+        return index <=> other.index;
+    }
+
+    reference operator*() const {
+        return std::apply([this](auto*... p) { return reference(p[index]...); }, ptrs);
+    }
+
+    // offset
+    self_type& operator+=(difference_type const offset) {
+        index += offset;
+        return *this;
+    }
+    self_type& operator-=(difference_type const offset) {
+        index -= offset;
+        return *this;
+    }
+    self_type operator+(difference_type offset) const {
+        self_type tmp = *this;
+        return tmp += offset;
+    }
+    friend self_type operator+(difference_type offset, self_type const& it) {
+        return it + offset;
+    }
+    self_type operator-(difference_type offset) const {
+        self_type tmp = *this;
+        return tmp -= offset;
+    }
+    difference_type operator-(self_type const& other) const {
+        assert(ptrs == other.ptrs);
+        return index - other.index;
+    }
+    // offset dereference operator ([])
+    reference operator[](difference_type const offset) const {
+        return *(*this + offset);
+    }
+
+    // move each column element out, instead of copying through the proxy
+    friend value_type iter_move(self_type const& it) {
+        return std::apply([&](auto*... p) { return value_type(std::move(p[it.index])...); }, it.ptrs);
+    }
+    friend void iter_swap(self_type const& a, self_type const& b) {
+        swap(*a, *b);
+    }
+};
+
+template <typename... Fields>
+class soa_vector {
+    std::tuple<std::vector<Fields>...> columns;
+
+    template <typename F>
+    void for_each_column(F&& f) {
+        std::apply([&](auto&... col) { (f(col), ...); }, columns);
+    }
+
+   public:
+    typedef std::tuple<Fields...> value_type;
+    typedef soa_iterator<Fields...> iterator;
+    typedef soa_iterator<Fields const...> constant_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<constant_iterator> reverse_constant_iterator;
+
+    size_t size() const { return std::get<0>(columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    void reserve(size_t const n) {
+        for_each_column([n](auto& col) { col.reserve(n); });
+    }
+    void resize(size_t const n) {
+        for_each_column([n](auto& col) { col.resize(n); });
+    }
+    void clear() {
+        for_each_column([](auto& col) { col.clear(); });
+    }
+
+    // if a field throws, the fields already appended are removed again, so all columns keep one length
+    template <typename... Args>
+    void emplace_back(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields));
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            size_t pushed = 0;
+            try {
+                ((std::get<I>(columns).emplace_back(std::forward<Args>(args)), ++pushed), ...);
+            } catch (...) {
+                ((I < pushed ? std::get<I>(columns).pop_back() : void()), ...);
+                throw;
+            }
+        }(std::index_sequence_for<Fields...>{});
+    }
+    void push_back(value_type v) {
+        std::apply([this](auto&&... f) { emplace_back(std::move(f)...); }, std::move(v));
+    }
+
+    // one field as a contiguous array, scans over it touch no other field
+    template <size_t I>
+    auto column() { return std::span(std::get<I>(columns)); }
+    template <size_t I>
+    auto column() const { return std::span(std::get<I>(columns)); }
+
+    soa_ref<Fields...> operator[](size_t const i) { return begin()[i]; }
+    soa_ref<Fields const...> operator[](size_t const i) const { return begin()[i]; }
+
+    iterator begin() {
+        return iterator(std::apply([](auto&... col) { return std::tuple(col.data()...); }, columns), 0);
+    }
+    iterator end() {
+        return begin() + size();
+    }
+    constant_iterator begin() const {
+        return constant_iterator(std::apply([](auto const&... col) { return std::tuple(col.data()...); }, columns), 0);
+    }
+    constant_iterator end() const {
+        return begin() + size();
+    }
+    constant_iterator cbegin() const {
+        return begin();
+    }
+    constant_iterator cend() const {
+        return end();
+    }
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+};
+
+static_assert(std::random_access_iterator<soa_vector<int, std::string>::iterator>);
+static_assert(std::permutable<soa_vector<int, std::string>::iterator>);
+static_assert(std::ranges::random_access_range<soa_vector<int, std::string> const>);
+
+template <typename... Fields>
+void print_tasks(soa_vector<Fields...> const& tasks) {
+    for (auto t : tasks) {
+        std::cout << get<1>(t) << ':' << get<0>(t) << '\n';
+    }
+}
+
+// the Task{priority, name} of ch06-iterator.cc, one column per member
+using tasks_t = soa_vector<int, std::string>;
+
+void test_example1() {
+    tasks_t tasks;
+    tasks.push_back({20, "task1"});
+    tasks.emplace_back(10, "task2");
+    tasks.emplace_back(30, "task3");
+    print_tasks(tasks);
+
+    // only the priority column is read, names stay out of the cache
+    auto prio = tasks.column<0>();
+    auto urgent = std::count_if(prio.begin(), prio.end(), [](int p) { return p >= 20; });
+    std::cout << "urgent tasks: " << urgent << '\n';
+
+    tasks[1] = tasks_t::value_type{15, "task2-updated"};
+    std::cout << get<1>(tasks[1]) << '\n';
+}
+
+void test_example2() {
+    tasks_t tasks;
+    tasks.emplace_back(20, "task1");
+    tasks.emplace_back(10, "task2");
+    tasks.emplace_back(30, "task3");
+    tasks.emplace_back(5, "task4");
+
+    // classic algorithm, rows move together
+    std::sort(tasks.begin(), tasks.end(), [](auto const& a, auto const& b) { return get<0>(a) < get<0>(b); });
+    print_tasks(tasks);
+
+    // ranges algorithm with a projection onto one field
+    std::ranges::sort(tasks, std::ranges::greater{}, [](auto const& t) { return get<0>(t); });
+    print_tasks(tasks);
+
+    for (auto t : tasks | std::views::filter([](auto const& t) { return get<0>(t) > 10; })
+                        | std::views::reverse) {
+        std::cout << get<1>(t) << ',';
+    }
+    std::cout << '\n';
+}
+
+int main() {
+    test_example1();
+    test_example2();
+}
@@ -0,0 +1,178 @@
+#include <algorithm>  // std::sort
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>  // std::iota, std::accumulate
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "ch06-dvd.h"
+#include "PerfTimer.h"
+
+// sorted string table over the titles of a catalog
+// titles are copied once into a single arena in sorted order, so a lookup touches
+// one offsets array and one contiguous char buffer, never the records themselves
+// the index is immutable after construction, concurrent readers need no locking
+class title_index {
+    std::string arena;
+    std::vector<std::uint32_t> offsets;  // title i is arena[offsets[i], offsets[i + 1])
+    std::vector<std::uint32_t> records;  // catalog position of title i
+
+    std::string_view key(size_t const i) const {
+        return std::string_view(arena).substr(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    size_t lower_bound(std::string_view const s) const {
+        size_t lo = 0, len = records.size();
+        while (len > 0) {
+            auto half = len / 2;
+            if (key(lo + half) < s) {
+                lo += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return lo;
+    }
+
+    // first position in [first, size) whose key does not start with prefix
+    size_t prefix_end(size_t first, std::string_view const prefix) const {
+        size_t len = records.size() - first;
+        while (len > 0) {
+            auto half = len / 2;
+            if (key(first + half).starts_with(prefix)) {
+                first += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return first;
+    }
+
+   public:
+    explicit title_index(std::vector<dvd> const& catalog) {
+        std::vector<std::string_view> titles;
+        titles.reserve(catalog.size());
+        size_t total = 0;
+        for (auto const& d : catalog) {
+            titles.push_back(std::visit([](auto const& arg) { return std::string_view(arg.title); }, d));
+            total += titles.back().size();
+        }
+        // offsets and record numbers are 32-bit to keep the arrays small
+        if (total > std::numeric_limits<std::uint32_t>::max() || catalog.size() > std::numeric_limits<std::uint32_t>::max())
+            throw std::length_error("title_index: titles do not fit 32-bit offsets");
+
+        std::vector<std::uint32_t> order(catalog.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) {
+            return titles[a] < titles[b] || (titles[a] == titles[b] && a < b);
+        });
+
+        arena.reserve(total);
+        offsets.reserve(catalog.size() + 1);
+        offsets.push_back(0);
+        records = std::move(order);
+        for (auto r : records) {
+            arena += titles[r];
+            offsets.push_back(static_cast<std::uint32_t>(arena.size()));
+        }
+    }
+
+    size_t size() const { return records.size(); }
+
+    // catalog positions of the records with exactly this title
+    std::span<std::uint32_t const> find(std::string_view const title) const {
+        auto first = lower_bound(title);
+        auto last = first;
+        while (last < records.size() && key(last) == title) ++last;
+        return std::span(records).subspan(first, last - first);
+    }
+
+    // catalog positions of the records whose title starts with prefix, ordered by title
+    std::span<std::uint32_t const> find_prefix(std::string_view const prefix) const {
+        auto first = lower_bound(prefix);
+        auto last = prefix_end(first, prefix);
+        return std::span(records).subspan(first, last - first);
+    }
+};
+
+std::string_view title_of(dvd const& d) {
+    return std::visit([](auto const& arg) { return std::string_view(arg.title); }, d);
+}
+
+int main() {
+    using namespace std::chrono_literals;
+
+    std::vector<dvd> dvds{
+        Movie{"The Matrix", 2h + 16min, {Genre::Action, Genre::SF}},
+        Music{"The Wall", "Pink Floyd", {{"Mother", 5min + 32s}, {"Another Brick in the Wall", 9min + 8s}}},
+        Software{"Windows", "Microsoft"},
+        Movie{"The Matrix Reloaded", 2h + 18min, {Genre::Action, Genre::SF}},
+        Software{"The Matrix", "Warner"},
+    };
+
+    // example1: exact and prefix search
+    {
+        title_index index(dvds);
+        for (auto i : index.find("The Matrix")) {
+            std::cout << "exact: " << i << ' ' << title_of(dvds[i]) << '\n';
+        }
+        for (auto i : index.find_prefix("The ")) {
+            std::cout << "prefix: " << i << ' ' << title_of(dvds[i]) << '\n';
+        }
+        std::cout << "missing: " << index.find("Linux").size() << '\n';
+    }
+    // example2: linear std::visit scan vs index, readers on several threads
+    {
+        constexpr int n = 1'000'000;
+        std::vector<dvd> catalog;
+        catalog.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            catalog.emplace_back(Software{"title-" + std::to_string(i * 7919LL % n), "vendor"});
+        }
+
+        title_index index(catalog);
+        std::vector<std::string> queries;
+        for (int i = 0; i < 100; ++i) queries.push_back("title-" + std::to_string(i * 9973LL % n));
+
+        size_t hits1 = 0;
+        auto t1 = perf_timer<>::duration([&] {
+            for (auto const& q : queries)
+                for (auto const& d : catalog)
+                    if (title_of(d) == q) ++hits1;
+        });
+
+        // each reader times its own query loop, thread start-up is not part of the cost
+        std::vector<size_t> hits(4);
+        std::vector<std::chrono::nanoseconds> costs(hits.size());
+        {
+            std::vector<std::thread> readers;
+            for (size_t t = 0; t < hits.size(); ++t) {
+                // counted in a local and stored once, adjacent slots of hits would share a cache line
+                readers.emplace_back([&, t] {
+                    size_t found = 0;
+                    costs[t] = perf_timer<std::chrono::nanoseconds>::duration([&] {
+                        for (auto const& q : queries) found += index.find(q).size();
+                    });
+                    hits[t] = found;
+                });
+            }
+            for (auto& r : readers) r.join();
+        }
+        auto t2 = std::accumulate(costs.begin(), costs.end(), std::chrono::nanoseconds{0});
+
+        std::cout << "linear scan hits: " << hits1 << ", cost per query: "
+                  << std::chrono::duration<double, std::micro>(t1) / queries.size() << '\n';
+        std::cout << "title index hits: " << hits[0] << ", cost per query: "
+                  << std::chrono::duration<double, std::micro>(t2) / (queries.size() * hits.size()) << '\n';
+        std::cout << "prefix title-99999*: " << index.find_prefix("title-99999").size() << '\n';
+    }
+}
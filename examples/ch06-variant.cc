@@ -1,47 +1,61 @@
-#include <algorithm>  // std::transform
-#include <chrono>
+#include <atomic>
+#include <cstdlib>  // std::malloc
+#include <functional>  // std::invoke
 #include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>  // std::move
 #include <variant>
 #include <vector>
 
-// upper string
-template <typename CharT>
-using tstring = std::basic_string<CharT, std::char_traits<CharT>, std::allocator<CharT>>;
+#include "ch06-dvd.h"
 
-template <typename CharT>
-inline tstring<CharT> to_upper(tstring<CharT> text) {
-    std::transform(std::begin(text), std::end(text), std::begin(text), toupper);
-    return text;
-}
-
-enum class Genre { Drama,
-                   Action,
-                   SF,
-                   Comedy };
+// count heap allocations, to check that the in-place transforms do not allocate
+std::atomic<std::size_t> alloc_count{0};
 
-struct Movie {
-    std::string title;
-    std::chrono::minutes length;
-    std::vector<Genre> genre;
-};
+void* operator new(std::size_t sz) {
+    ++alloc_count;
+    if (auto p = std::malloc(sz)) return p;
+    throw std::bad_alloc{};
+}
 
-struct Track {
-    std::string title;
-    std::chrono::seconds length;
-};
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
 
-struct Music {
-    std::string title;
-    std::string artist;
-    std::vector<Track> tracks;
-};
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
 
-struct Software {
-    std::string title;
-    std::string vendor;
-};
+// mutate the active alternative in place, f takes it by lvalue reference
+template <typename F, typename... Ts>
+void visit_inplace(F&& f, std::variant<Ts...>& v) {
+    std::visit([&](auto& arg) { std::invoke(f, arg); }, v);
+}
 
-using dvd = std::variant<Movie, Music, Software>;
+// batch transform over a range of variants
+// - f(T&) returning void mutates in place
+// - otherwise the alternative is moved into f and the result is moved back,
+//   into the same alternative without touching the variant index when the type is unchanged
+template <typename Range, typename F>
+void transform_inplace(Range& range, F&& f) {
+    for (auto& v : range) {
+        std::visit([&](auto& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_invocable_v<F&, T&> &&
+                          std::is_void_v<std::invoke_result_t<F&, T&>>) {
+                std::invoke(f, arg);
+            } else {
+                auto result = std::invoke(f, std::move(arg));
+                if constexpr (std::is_same_v<decltype(result), T>)
+                    arg = std::move(result);
+                else
+                    v = std::move(result);  // arg is not used after this
+            }
+        },
+                   v);
+    }
+}
 
 int main() {
     using namespace std::chrono_literals;
@@ -130,4 +144,42 @@ int main() {
                        d);
         }
     }
-}
+    // example4: in-place transforms, the titles are uppercased without copying the records
+    {
+        visit_inplace([](auto& arg) { to_upper_inplace(arg.title); }, dvds[0]);
+
+        // mutating visitor
+        transform_inplace(dvds, [](auto& arg) { to_upper_inplace(arg.title); });
+
+        // value returning visitor, the record is moved in and moved back
+        transform_inplace(dvds, [](auto&& arg) {
+            auto cpy{std::move(arg)};
+            cpy.title += " (HD)";
+            return cpy;
+        });
+
+        for (auto const& d : dvds) {
+            std::visit([](auto&& arg) { std::cout << arg.title << '\n'; }, d);
+        }
+
+        std::vector<dvd> catalog;
+        for (int i = 0; i < 100'000; ++i) {
+            catalog.emplace_back(Software{"a title that does not fit in the small string buffer", "vendor"});
+        }
+        auto before = alloc_count.load();
+        transform_inplace(catalog, [](auto& arg) { to_upper_inplace(arg.title); });
+        std::cout << "allocations for in-place transform: " << alloc_count - before << '\n';  // 0
+
+        before = alloc_count.load();
+        for (auto& d : catalog) {
+            d = std::visit(
+                [](auto&& arg) -> dvd {
+                    auto cpy{arg};
+                    cpy.title = to_upper(cpy.title);
+                    return cpy;
+                },
+                d);
+        }
+        std::cout << "allocations for copying visitor: " << alloc_count - before << '\n';
+    }
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+// Linux only: directory sizes kept current from inotify events
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>  // lstat
+#include <unistd.h>
+
+#include <algorithm>  // std::sort
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>  // make_unique
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>  // std::exchange
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Computes per-directory totals once, then applies inotify events as deltas that are propagated
+// up to the root. Queries take a shared lock and read one number; the watcher scans new subtrees
+// without the lock and only takes it to swap them in.
+// Sizes are those of regular files; symlinks are not followed, hard links are counted once per link.
+class dir_size_cache {
+    struct node {
+        node* parent = nullptr;
+        std::string path;
+        int wd = -1;
+        std::uintmax_t total = 0;
+        std::unordered_map<std::string, std::uintmax_t> files;
+        std::unordered_map<std::string, std::unique_ptr<node>> dirs;
+    };
+
+    static constexpr std::uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE |
+                                                IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+    int inotify_fd = -1;
+    int stop_fd = -1;
+    fs::path root_path;
+    // queries read by_path, unwatched, watching and the totals under the shared lock; the watcher thread
+    // is the only writer, so it reads them without the lock and takes it exclusively to change them.
+    // by_wd is used by the watcher thread alone.
+    std::unique_ptr<node> root;
+    std::unordered_map<int, node*> by_wd;
+    std::unordered_map<std::string, node*> by_path;
+    std::unordered_set<std::string> unwatched;  // directories inotify_add_watch failed for, ENOSPC mostly
+    bool watching = true;
+    mutable std::shared_mutex mtx;
+    std::thread watcher;
+
+    static void propagate(node* n, std::intmax_t const delta) {
+        for (; n != nullptr; n = n->parent) n->total += static_cast<std::uintmax_t>(delta);
+    }
+
+    // builds the subtree without the lock, adopt() publishes it.
+    // the watch is added before listing, so nothing created meanwhile is missed,
+    // events for entries already seen by the scan are harmless since updates are absolute
+    std::unique_ptr<node> scan(std::string path, node* parent) {
+        auto n = std::make_unique<node>();
+        n->parent = parent;
+        n->path = std::move(path);
+        n->wd = inotify_add_watch(inotify_fd, n->path.c_str(), watch_mask);
+
+        auto ec = std::error_code{};
+        for (auto it = fs::directory_iterator(n->path, fs::directory_options::skip_permission_denied, ec);
+             !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            auto const& entry = *it;
+            auto name = entry.path().filename().string();
+            if (entry.is_symlink(ec)) {
+                // not followed
+            } else if (entry.is_directory(ec)) {
+                auto child = scan(entry.path().string(), n.get());
+                n->total += child->total;
+                n->dirs[name] = std::move(child);
+            } else if (entry.is_regular_file(ec)) {
+                auto size = entry.file_size(ec);
+                if (!ec) {
+                    n->files[name] = size;
+                    n->total += size;
+                }
+            }
+            ec.clear();
+        }
+        return n;
+    }
+
+    // under the exclusive lock
+    void adopt(node* n) {
+        for (auto& [name, child] : n->dirs) adopt(child.get());
+        if (n->wd >= 0)
+            by_wd[n->wd] = n;
+        else
+            unwatched.insert(n->path);
+        by_path[n->path] = n;
+    }
+
+    // before the subtree is scanned again: the new scan would get the same watch descriptors back
+    void unwatch(node* n) {
+        for (auto& [name, child] : n->dirs) unwatch(child.get());
+        if (n->wd >= 0) {
+            inotify_rm_watch(inotify_fd, n->wd);
+            by_wd.erase(n->wd);
+        }
+    }
+
+    // under the exclusive lock
+    void forget(node* n) {
+        for (auto& [name, child] : n->dirs) forget(child.get());
+        by_path.erase(n->path);
+        unwatched.erase(n->path);
+    }
+
+    // scan the subtree of n again (the whole tree if n is the root) and swap it in
+    void rescan(node* n) {
+        unwatch(n);
+        auto fresh = scan(n->path, n->parent);
+        std::unique_ptr<node> old;  // freed after the lock is released
+        std::unique_lock lock(mtx);
+        forget(n);
+        adopt(fresh.get());
+        if (n->parent == nullptr) {
+            old = std::exchange(root, std::move(fresh));
+        } else {
+            propagate(n->parent, static_cast<std::intmax_t>(fresh->total) - static_cast<std::intmax_t>(n->total));
+            auto& slot = n->parent->dirs[fs::path(n->path).filename().string()];
+            old = std::exchange(slot, std::move(fresh));
+        }
+    }
+
+    void rebuild() {
+        if (root) {
+            rescan(root.get());
+        } else {
+            auto fresh = scan(root_path.string(), nullptr);
+            std::unique_lock lock(mtx);
+            adopt(fresh.get());
+            root = std::move(fresh);
+        }
+    }
+
+    // watches may have been freed since, try the topmost unwatched directories again
+    void retry_unwatched() {
+        std::vector<std::string> paths(unwatched.begin(), unwatched.end());
+        std::sort(paths.begin(), paths.end());  // a directory before everything under it
+        std::string done;
+        for (auto const& path : paths) {
+            if (!done.empty() && path.starts_with(done) && path[done.size()] == '/') continue;  // rescanned with it
+            auto it = by_path.find(path);
+            if (it == by_path.end() || it->second->wd >= 0) continue;
+            rescan(it->second);
+            done = path;
+        }
+    }
+
+    void refresh_file(node* n, std::string const& name) {
+        struct stat st {};
+        auto full = n->path + '/' + name;
+        std::uintmax_t size = 0;
+        bool exists = ::lstat(full.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+        if (exists) size = static_cast<std::uintmax_t>(st.st_size);
+
+        std::unique_lock lock(mtx);
+        auto it = n->files.find(name);
+        std::uintmax_t old = it != n->files.end() ? it->second : 0;
+        if (exists)
+            n->files[name] = size;
+        else if (it != n->files.end())
+            n->files.erase(it);
+        propagate(n, static_cast<std::intmax_t>(size) - static_cast<std::intmax_t>(old));
+    }
+
+    void add_dir(node* n, std::string const& name) {
+        auto child = scan(n->path + '/' + name, n);
+        std::unique_lock lock(mtx);
+        adopt(child.get());
+        propagate(n, static_cast<std::intmax_t>(child->total));
+        n->dirs[name] = std::move(child);
+    }
+
+    void remove_dir(node* n, std::string const& name) {
+        auto it = n->dirs.find(name);
+        if (it == n->dirs.end()) return;
+        unwatch(it->second.get());
+        std::unique_ptr<node> old;  // freed after the lock is released
+        std::unique_lock lock(mtx);
+        propagate(n, -static_cast<std::intmax_t>(it->second->total));
+        forget(it->second.get());
+        old = std::move(it->second);
+        n->dirs.erase(it);
+    }
+
+    void apply(inotify_event const& ev) {
+        if (ev.mask & IN_Q_OVERFLOW) {
+            rebuild();  // events were lost, start over
+            return;
+        }
+        auto it = by_wd.find(ev.wd);
+        if (it == by_wd.end() || ev.len == 0) return;
+        node* n = it->second;
+        std::string name(ev.name);
+
+        if (ev.mask & IN_ISDIR) {
+            if (ev.mask & (IN_DELETE | IN_MOVED_FROM))
+                remove_dir(n, name);
+            else if ((ev.mask & (IN_CREATE | IN_MOVED_TO)) && !n->dirs.contains(name))
+                add_dir(n, name);
+        } else {
+            refresh_file(n, name);
+        }
+    }
+
+    // sleeps in poll() between events, no CPU when idle; wakes up every second while some directory is unwatched
+    void watch_loop() {
+        alignas(inotify_event) char buffer[64 * 1024];
+        pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+        for (;;) {
+            auto ready = ::poll(fds, 2, unwatched.empty() ? -1 : 1000);
+            if (ready == 0) {
+                retry_unwatched();
+                continue;
+            }
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready < 0 || (fds[1].revents & POLLIN)) break;
+            auto n = ::read(inotify_fd, buffer, sizeof(buffer));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            if (n <= 0) break;
+
+            for (char* p = buffer; p < buffer + n;) {
+                auto ev = reinterpret_cast<inotify_event const*>(p);
+                apply(*ev);
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        std::unique_lock lock(mtx);
+        watching = false;  // stopped, or poll/read failed and the sizes are no longer kept current
+    }
+
+   public:
+    explicit dir_size_cache(fs::path const& path) : root_path(fs::canonical(path)) {
+        inotify_fd = inotify_init1(IN_CLOEXEC);
+        stop_fd = eventfd(0, EFD_CLOEXEC);
+        if (inotify_fd < 0 || stop_fd < 0) throw std::runtime_error("inotify not available");
+        rebuild();
+        watcher = std::thread([this] { watch_loop(); });
+    }
+
+    ~dir_size_cache() {
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto r = ::write(stop_fd, &one, sizeof(one));
+        watcher.join();
+        ::close(inotify_fd);
+        ::close(stop_fd);
+    }
+
+    dir_size_cache(dir_size_cache const&) = delete;
+    dir_size_cache& operator=(dir_size_cache const&) = delete;
+
+    // total size under a directory of the watched tree
+    std::optional<std::uintmax_t> size(fs::path const& dir) const {
+        auto key = (dir.is_absolute() ? dir : fs::absolute(dir)).lexically_normal().string();
+        if (key.size() > 1 && key.back() == '/') key.pop_back();
+        std::shared_lock lock(mtx);
+        auto it = by_path.find(key);
+        if (it == by_path.end()) return std::nullopt;
+        return it->second->total;
+    }
+
+    std::uintmax_t size() const {
+        std::shared_lock lock(mtx);
+        return root->total;
+    }
+
+    // false while some directory could not be watched or after the watcher stopped on an error,
+    // the sizes may then be stale
+    bool exact() const {
+        std::shared_lock lock(mtx);
+        return watching && unwatched.empty();
+    }
+};
+
+int main() {
+    using namespace std::chrono_literals;
+
+    auto path = fs::canonical(fs::temp_directory_path()) / "dir_size_cache_test";
+    fs::create_directories(path / "a" / "b");
+    std::ofstream(path / "a" / "f1.bin") << std::string(100, 'x');
+    std::ofstream(path / "a" / "b" / "f2.bin") << std::string(200, 'x');
+
+    {
+        dir_size_cache cache(path);
+        std::cout << "initial: " << cache.size() << ", exact: " << cache.exact() << '\n';  // 300, 1
+
+        std::ofstream(path / "a" / "b" / "f3.bin") << std::string(1000, 'x');
+        std::this_thread::sleep_for(100ms);
+        std::cout << "after create: " << cache.size() << ", a/b: " << *cache.size(path / "a" / "b") << '\n';  // 1300, 1200
+
+        fs::create_directories(path / "c");
+        std::ofstream(path / "c" / "f4.bin") << std::string(50, 'x');
+        fs::resize_file(path / "a" / "f1.bin", 10);
+        std::this_thread::sleep_for(100ms);
+        std::cout << "after mkdir/truncate: " << cache.size() << '\n';  // 1260
+
+        fs::remove_all(path / "a");
+        std::this_thread::sleep_for(100ms);
+        std::cout << "after rmdir: " << cache.size() << ", a: " << cache.size(path / "a").has_value() << '\n';  // 50, 0
+    }
+
+    fs::remove_all(path);
+}
@@ -59,7 +59,7 @@ void visit_directory(fs::path const& dir, bool const recursive = false, unsigned
 }
 
 std::uintmax_t dir_size(fs::path const& path) {
-    auto size = 0;
+    std::uintmax_t size = 0;
 
     if (fs::exists(path) && fs::is_directory(path)) {
         for (auto const& entry : fs::recursive_directory_iterator(path)) {
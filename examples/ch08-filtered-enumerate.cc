@@ -0,0 +1,162 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>  // std::quoted
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// shell style pattern: * any run, ? one char, [abc] [a-z] [!abc] a set
+bool glob_match(std::string_view pattern, std::string_view name) {
+    size_t p = 0, n = 0;
+    size_t star_p = std::string_view::npos, star_n = 0;
+
+    auto match_set = [&](size_t& pp, char c) {
+        // pattern[pp] == '['
+        size_t i = pp + 1;
+        bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate) ++i;
+        bool found = false;
+        for (bool first = true; i < pattern.size() && (first || pattern[i] != ']'); first = false) {
+            if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+                found |= pattern[i] <= c && c <= pattern[i + 2];
+                i += 3;
+            } else {
+                found |= pattern[i] == c;
+                ++i;
+            }
+        }
+        pp = i + 1;  // past ']'
+        return found != negate;
+    };
+
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            star_p = p++;
+            star_n = n;
+            continue;
+        }
+        if (p < pattern.size()) {
+            auto next = p;
+            bool ok = pattern[p] == '?' ? (++next, true)
+                      : pattern[p] == '[' ? match_set(next, name[n])
+                                          : (++next, pattern[p] == name[n]);
+            if (ok) {
+                p = next;
+                ++n;
+                continue;
+            }
+        }
+        if (star_p == std::string_view::npos) return false;
+        // backtrack: the last * takes one more char
+        p = star_p + 1;
+        n = ++star_n;
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// Filters are checked from the cheapest to the most expensive:
+//   1. directory patterns, per depth, prune whole subtrees before they are opened
+//   2. name tests (extensions, glob), answered from the directory listing alone
+//   3. size and mtime, the only tests that need a stat, and only for names that passed
+struct enum_filter {
+    std::vector<std::string> dir_patterns;  // dir_patterns[d] must match a directory at depth d
+    std::optional<int> max_depth;
+    std::vector<std::string> extensions;  // e.g. ".bin"; empty accepts all
+    std::string name_glob;                // empty accepts all
+    std::optional<std::uintmax_t> min_size;
+    std::optional<std::uintmax_t> max_size;
+    std::optional<fs::file_time_type> newer_than;
+    std::optional<fs::file_time_type> older_than;
+
+    bool accept_dir(std::string const& name, int const depth) const {
+        if (max_depth && depth >= *max_depth) return false;
+        return depth >= static_cast<int>(dir_patterns.size()) || glob_match(dir_patterns[depth], name);
+    }
+
+    bool accept_name(fs::path const& filename) const {
+        if (!extensions.empty()) {
+            auto ext = filename.extension().string();
+            bool found = false;
+            for (auto const& e : extensions) found |= e == ext;
+            if (!found) return false;
+        }
+        return name_glob.empty() || glob_match(name_glob, filename.string());
+    }
+
+    bool needs_stat() const { return min_size || max_size || newer_than || older_than; }
+
+    bool accept_stat(fs::directory_entry const& entry, std::error_code& ec) const {
+        if (min_size || max_size) {
+            auto size = entry.file_size(ec);
+            if (ec || (min_size && size < *min_size) || (max_size && size > *max_size)) return false;
+        }
+        if (newer_than || older_than) {
+            auto mtime = entry.last_write_time(ec);
+            if (ec || (newer_than && mtime <= *newer_than) || (older_than && mtime >= *older_than)) return false;
+        }
+        return true;
+    }
+};
+
+// calls f(directory_entry const&) for each regular file that passes the filter
+template <typename F>
+void visit_directory_filtered(fs::path const& dir, enum_filter const& filter, F&& f) {
+    auto ec = std::error_code{};
+    auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        auto const& entry = *it;
+        auto filename = entry.path().filename();
+
+        // the type comes from the cached directory entry, not from a stat
+        if (entry.is_directory(ec)) {
+            if (!filter.accept_dir(filename.string(), it.depth()))
+                it.disable_recursion_pending();
+        } else if (entry.is_regular_file(ec) && filter.accept_name(filename)) {
+            if (!filter.needs_stat() || filter.accept_stat(entry, ec))
+                f(entry);
+        }
+        ec.clear();
+    }
+}
+
+int main() {
+    auto path = fs::temp_directory_path() / "filtered_enumerate_test";
+    // date-partitioned layout: yyyy-mm-dd/hh/*.bin|*.csv
+    for (auto day : {"2024-01-30", "2024-01-31", "2024-02-01", "2024-02-02"}) {
+        for (auto hour : {"00", "12"}) {
+            auto sub = path / day / hour;
+            fs::create_directories(sub);
+            std::ofstream(sub / "ticks.bin") << std::string(hour[0] == '0' ? 10 : 1000, 'x');
+            std::ofstream(sub / "ticks.csv") << "x";
+        }
+    }
+
+    // example1: only *.bin of February, the January subtrees are never opened
+    {
+        enum_filter filter;
+        filter.dir_patterns = {"2024-02-*"};
+        filter.extensions = {".bin"};
+        visit_directory_filtered(path, filter, [&](fs::directory_entry const& e) {
+            std::cout << std::quoted(fs::relative(e.path(), path).string()) << '\n';
+        });
+    }
+    // example2: glob on the name, then stat only those names for the size
+    {
+        enum_filter filter;
+        filter.dir_patterns = {"2024-0[12]-3?", "1*"};
+        filter.name_glob = "tick*.bin";
+        filter.min_size = 100;
+        filter.newer_than = fs::file_time_type::clock::now() - std::chrono::hours(1);
+        visit_directory_filtered(path, filter, [&](fs::directory_entry const& e) {
+            std::cout << std::quoted(fs::relative(e.path(), path).string()) << ' ' << e.file_size() << '\n';
+        });
+    }
+
+    fs::remove_all(path);
+}
@@ -0,0 +1,272 @@
+// POSIX write(2), the listing goes to a file descriptor
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>  // std::to_chars
+#include <chrono>
+#include <cstring>  // std::memcpy
+#include <filesystem>
+#include <fstream>
+#include <iomanip>     // std::quoted
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "PerfTimer.h"
+
+namespace fs = std::filesystem;
+
+enum class entry_kind { directory,
+                        symlink,
+                        regular,
+                        other };
+
+enum class listing_format {
+    nul,      // path\0, for xargs -0
+    jsonl,    // {"path":"...","type":"file","size":123}\n
+    columns,  // [+]        size  path\n, the markers of visit_directory
+};
+
+// formats entries into one reusable buffer, handed to the kernel with a single write(2) per block
+class listing_writer {
+    int fd;
+    listing_format format;
+    std::vector<char> buffer;
+    size_t used = 0;
+
+    void append(std::string_view s) {
+        if (used + s.size() > buffer.size()) {
+            flush();
+            if (s.size() > buffer.size()) buffer.resize(s.size());
+        }
+        std::memcpy(buffer.data() + used, s.data(), s.size());
+        used += s.size();
+    }
+    void append(char const c) { append(std::string_view(&c, 1)); }
+
+    void append_number(std::uintmax_t const v, int const width = 0) {
+        char digits[24];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), v);
+        auto len = static_cast<int>(end - digits);
+        for (int i = len; i < width; ++i) append(' ');
+        append(std::string_view(digits, len));
+    }
+
+    // length of the well-formed UTF-8 sequence starting at s[i], 0 if there is none
+    static size_t utf8_length(std::string_view s, size_t const i) {
+        auto at = [&](size_t const k) { return i + k < s.size() ? static_cast<unsigned char>(s[i + k]) : 0u; };
+        auto cont = [&](size_t const k) { return (at(k) & 0xC0) == 0x80; };
+        auto c = at(0);
+        if (c < 0x80) return 1;
+        if (c >= 0xC2 && c <= 0xDF) return cont(1) ? 2 : 0;
+        if (c >= 0xE0 && c <= 0xEF) {
+            auto lo = c == 0xE0 ? 0xA0u : 0x80u, hi = c == 0xED ? 0x9Fu : 0xBFu;  // no overlongs, no surrogates
+            return at(1) >= lo && at(1) <= hi && cont(2) ? 3 : 0;
+        }
+        if (c >= 0xF0 && c <= 0xF4) {
+            auto lo = c == 0xF0 ? 0x90u : 0x80u, hi = c == 0xF4 ? 0x8Fu : 0xBFu;  // no overlongs, nothing above U+10FFFF
+            return at(1) >= lo && at(1) <= hi && cont(2) && cont(3) ? 4 : 0;
+        }
+        return 0;
+    }
+
+    static bool valid_utf8(std::string_view s) {
+        for (size_t i = 0, len; i < s.size(); i += len)
+            if ((len = utf8_length(s, i)) == 0) return false;
+        return true;
+    }
+
+    void append_base64(std::string_view s) {
+        static constexpr char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        append('"');
+        for (size_t i = 0; i < s.size(); i += 3) {
+            auto byte = [&](size_t const k) { return i + k < s.size() ? static_cast<unsigned char>(s[i + k]) : 0u; };
+            auto bits = byte(0) << 16 | byte(1) << 8 | byte(2);
+            char quad[] = {digits[bits >> 18], digits[bits >> 12 & 0x3F], digits[bits >> 6 & 0x3F], digits[bits & 0x3F]};
+            if (i + 1 >= s.size()) quad[2] = '=';
+            if (i + 2 >= s.size()) quad[3] = '=';
+            append(std::string_view(quad, sizeof(quad)));
+        }
+        append('"');
+    }
+
+    // paths are bytes, not text: a byte that is not part of valid UTF-8 is written as \ufffd,
+    // so the line stays valid JSON but the string is lossy; add() then also writes the exact bytes
+    void append_json_string(std::string_view s) {
+        static constexpr char hex[] = "0123456789abcdef";
+        append('"');
+        size_t start = 0;
+        for (size_t i = 0; i < s.size();) {
+            auto c = static_cast<unsigned char>(s[i]);
+            auto len = utf8_length(s, i);
+            if (len > 1 || (len == 1 && c >= 0x20 && c != '"' && c != '\\')) {
+                i += len;
+                continue;
+            }
+            append(s.substr(start, i - start));
+            start = i + 1;
+            switch (c) {
+                case '"': append("\\\""); break;
+                case '\\': append("\\\\"); break;
+                case '\n': append("\\n"); break;
+                case '\t': append("\\t"); break;
+                default:
+                    if (c < 0x20) {
+                        char esc[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                        append(std::string_view(esc, sizeof(esc)));
+                    } else
+                        append("\\ufffd");
+            }
+            ++i;
+        }
+        append(s.substr(start));
+        append('"');
+    }
+
+    static std::string_view type_name(entry_kind const kind) {
+        switch (kind) {
+            case entry_kind::directory: return "dir";
+            case entry_kind::symlink: return "symlink";
+            case entry_kind::regular: return "file";
+            default: return "other";
+        }
+    }
+    static std::string_view marker(entry_kind const kind) {
+        switch (kind) {
+            case entry_kind::directory: return "[+]";
+            case entry_kind::symlink: return "[>]";
+            case entry_kind::regular: return "   ";
+            default: return "[?]";
+        }
+    }
+
+   public:
+    explicit listing_writer(int const fd, listing_format const format, size_t const block_size = 1 << 20)
+        : fd(fd), format(format), buffer(block_size) {}
+
+    // without close() the rest is flushed here, and a failed write goes unnoticed
+    ~listing_writer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    listing_writer(listing_writer const&) = delete;
+    listing_writer& operator=(listing_writer const&) = delete;
+
+    void add(std::string_view path, entry_kind const kind, std::uintmax_t const size = 0) {
+        switch (format) {
+            case listing_format::nul:
+                append(path);
+                append('\0');
+                break;
+            case listing_format::jsonl:
+                append("{\"path\":");
+                append_json_string(path);
+                if (!valid_utf8(path)) {  // "path" lost bytes, base64 of the name as it is on disk
+                    append(",\"path_bytes\":");
+                    append_base64(path);
+                }
+                append(",\"type\":\"");
+                append(type_name(kind));
+                append("\",\"size\":");
+                append_number(size);
+                append("}\n");
+                break;
+            case listing_format::columns:
+                append(marker(kind));
+                append(' ');
+                append_number(size, 14);
+                append("  ");
+                append(path);
+                append('\n');
+                break;
+        }
+    }
+
+    void add(fs::directory_entry const& entry) {
+        auto ec = std::error_code{};
+        auto kind = entry.is_symlink(ec)      ? entry_kind::symlink
+                    : entry.is_directory(ec)    ? entry_kind::directory
+                    : entry.is_regular_file(ec) ? entry_kind::regular
+                                                : entry_kind::other;
+        std::uintmax_t size = 0;
+        if (kind == entry_kind::regular) {
+            size = entry.file_size(ec);
+            if (ec) size = 0;
+        }
+        add(entry.path().native(), kind, size);
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < used) {
+            auto n = ::write(fd, buffer.data() + done, used - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                used = 0;
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            done += static_cast<size_t>(n);
+        }
+        used = 0;
+    }
+
+    // writes what is left, throws std::system_error if the write fails
+    void close() { flush(); }
+};
+
+int main(int argc, char const* argv[]) {
+    auto path = fs::temp_directory_path() / "listing_writer_test";
+    bool const generated = argc < 2;
+    if (generated) {
+        for (int i = 0; i < 100; ++i) {
+            auto dir = path / std::to_string(i);
+            fs::create_directories(dir);
+            for (int k = 0; k < 100; ++k) std::ofstream(dir / ("file \"" + std::to_string(k) + "\".bin")) << k;
+        }
+    } else {
+        path = argv[1];
+    }
+
+    // example1: one of each format to stdout
+    {
+        auto dir = path / "0";
+        for (auto format : {listing_format::columns, listing_format::jsonl}) {
+            listing_writer out(STDOUT_FILENO, format);
+            int count = 0;
+            for (auto const& entry : fs::directory_iterator(dir)) {
+                if (count++ == 3) break;
+                out.add(entry);
+            }
+            out.close();
+        }
+    }
+    // example2: per-line iostream vs blocks of write(2), both into /dev/null
+    {
+        std::vector<fs::directory_entry> entries(fs::recursive_directory_iterator(path), fs::recursive_directory_iterator{});
+
+        std::ofstream devnull("/dev/null");
+        auto t1 = perf_timer<>::duration([&] {
+            for (auto const& entry : entries) devnull << std::quoted(entry.path().string()) << '\n';
+        });
+
+        int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        auto t2 = perf_timer<>::duration([&] {
+            listing_writer out(fd, listing_format::nul);
+            for (auto const& entry : entries) out.add(entry.path().native(), entry_kind::other);
+            out.close();
+        });
+        ::close(fd);
+
+        std::cout << "entries: " << entries.size() << '\n';
+        std::cout << "      iostream cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "listing_writer cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+
+    if (generated) fs::remove_all(path);
+}
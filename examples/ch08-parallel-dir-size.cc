@@ -0,0 +1,142 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PerfTimer.h"
+
+namespace fs = std::filesystem;
+
+// one queue of pending directories per worker
+// the owner pushes and pops at the back (depth first, good locality),
+// idle workers steal from the front, where the largest unexplored subtrees are
+class directory_queue {
+    std::deque<fs::path> dirs;
+    std::mutex mtx;
+
+   public:
+    void push(fs::path dir) {
+        std::lock_guard lock(mtx);
+        dirs.push_back(std::move(dir));
+    }
+    std::optional<fs::path> pop() {
+        std::lock_guard lock(mtx);
+        if (dirs.empty()) return std::nullopt;
+        auto dir = std::move(dirs.back());
+        dirs.pop_back();
+        return dir;
+    }
+    std::optional<fs::path> steal() {
+        std::lock_guard lock(mtx);
+        if (dirs.empty()) return std::nullopt;
+        auto dir = std::move(dirs.front());
+        dirs.pop_front();
+        return dir;
+    }
+};
+
+// the same sum as dir_size in ch08-enumerate-files.cc, with one directory per task
+// the entry type comes from the cached directory_entry (d_type on Linux), so every
+// file costs a single stat for its size instead of status() plus file_size()
+std::uintmax_t dir_size_parallel(fs::path const& path, unsigned thread_nums = std::thread::hardware_concurrency()) {
+    auto err = std::error_code{};
+    if (!fs::is_directory(path, err)) return 0;
+    if (thread_nums == 0) thread_nums = 1;
+
+    std::vector<directory_queue> queues(thread_nums);
+    std::atomic<std::size_t> pending{1};  // directories pushed but not yet scanned
+    std::atomic<std::uintmax_t> total{0};
+    queues[0].push(path);
+
+    auto worker = [&](unsigned const id) {
+        std::uintmax_t local = 0;
+        while (pending.load(std::memory_order_acquire) > 0) {
+            auto dir = queues[id].pop();
+            for (unsigned i = 1; !dir && i < thread_nums; ++i) {
+                dir = queues[(id + i) % thread_nums].steal();
+            }
+            if (!dir) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            auto ec = std::error_code{};
+            for (auto it = fs::directory_iterator(*dir, fs::directory_options::skip_permission_denied, ec);
+                 !ec && it != fs::directory_iterator(); it.increment(ec)) {
+                auto const& entry = *it;
+                if (entry.is_symlink(ec)) {
+                    // like dir_size: counted with the size of the target, never descended into
+                    auto size = entry.file_size(ec);
+                    if (!ec) local += size;
+                } else if (entry.is_directory(ec)) {
+                    pending.fetch_add(1, std::memory_order_relaxed);
+                    queues[id].push(entry.path());
+                } else if (entry.is_regular_file(ec)) {
+                    auto size = entry.file_size(ec);
+                    if (!ec) local += size;
+                }
+                ec.clear();
+            }
+            pending.fetch_sub(1, std::memory_order_release);
+        }
+        total.fetch_add(local, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < thread_nums; ++i) threads.emplace_back(worker, i);
+    worker(0);
+    for (auto& t : threads) t.join();
+
+    return total;
+}
+
+std::uintmax_t dir_size(fs::path const& path) {
+    std::uintmax_t size = 0;
+
+    if (fs::exists(path) && fs::is_directory(path)) {
+        for (auto const& entry : fs::recursive_directory_iterator(path)) {
+            if (fs::is_regular_file(entry.status()) || fs::is_symlink(entry.status())) {
+                auto filesize = fs::file_size(entry);
+                if (filesize != static_cast<uintmax_t>(-1))
+                    size += filesize;
+            }
+        }
+    }
+
+    return size;
+}
+
+int main(int argc, char const* argv[]) {
+    auto path = fs::temp_directory_path() / "dir_size_test";
+    bool const generated = argc < 2;
+    if (generated) {
+        // 20 x 20 directories with 10 files each
+        for (int i = 0; i < 20; ++i) {
+            for (int j = 0; j < 20; ++j) {
+                auto dir = path / std::to_string(i) / std::to_string(j);
+                fs::create_directories(dir);
+                for (int k = 0; k < 10; ++k) {
+                    std::ofstream(dir / (std::to_string(k) + ".bin")) << std::string(100 + k, 'x');
+                }
+            }
+        }
+    } else {
+        path = argv[1];
+    }
+
+    std::uintmax_t s1 = 0, s2 = 0;
+    auto t1 = perf_timer<>::duration([&] { s1 = dir_size(path); });
+    auto t2 = perf_timer<>::duration([&] { s2 = dir_size_parallel(path); });
+    std::cout << "  sequential size: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+    std::cout << "work-stealing size: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+
+    if (generated) fs::remove_all(path);
+}
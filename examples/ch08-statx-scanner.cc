@@ -0,0 +1,355 @@
+// Linux only: getdents64 + statx, with an optional io_uring batch for the statx calls
+#include <dirent.h>  // DT_DIR
+#include <fcntl.h>   // openat, AT_SYMLINK_NOFOLLOW
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>  // statx
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>  // std::max, std::min
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>  // std::memset, std::strerror
+#include <filesystem>
+#include <iomanip>  // std::quoted
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// the same four kinds as visit_directory in ch08-enumerate-files.cc
+enum class entry_kind { directory,
+                        symlink,
+                        regular,
+                        other };
+
+// metadata to fetch, entries are only stat'ed when a field needs it
+enum scan_fields : unsigned {
+    sf_none = 0,
+    sf_size = 1,
+    sf_mtime = 2,
+};
+
+struct scan_entry {
+    int dirfd;  // the open parent directory, for openat/statx relative to it
+    std::string_view name;
+    entry_kind kind;
+    std::uint64_t size;  // with sf_size
+    std::int64_t mtime;  // with sf_mtime, seconds since epoch
+    int error;  // errno of a failed statx, kind is then what getdents said and size/mtime are unknown
+};
+
+// minimal io_uring (no liburing): one submission of up to `entries` statx, then wait for all of them
+class statx_ring {
+    int fd = -1;
+    io_uring_params params{};
+    void* sq_ptr = MAP_FAILED;
+    void* cq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    template <typename T>
+    static T* at(void* base, unsigned offset) { return reinterpret_cast<T*>(static_cast<char*>(base) + offset); }
+
+   public:
+    explicit statx_ring(unsigned const entries) {
+        if (entries == 0) return;
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return;  // no io_uring (old kernel, seccomp, disabled by sysctl)
+        if (!supports(IORING_OP_STATX)) {  // io_uring before 5.6 has no statx, and no probe either
+            release();
+            return;
+        }
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = std::max(sq_size, cq_size);
+
+        sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cq_ptr = (params.features & IORING_FEAT_SINGLE_MMAP)
+                     ? sq_ptr
+                     : ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+                                                 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED) {
+            release();
+            return;
+        }
+
+        sq_tail = at<unsigned>(sq_ptr, params.sq_off.tail);
+        sq_mask = at<unsigned>(sq_ptr, params.sq_off.ring_mask);
+        sq_array = at<unsigned>(sq_ptr, params.sq_off.array);
+        cq_head = at<unsigned>(cq_ptr, params.cq_off.head);
+        cq_tail = at<unsigned>(cq_ptr, params.cq_off.tail);
+        cq_mask = at<unsigned>(cq_ptr, params.cq_off.ring_mask);
+        cqes = at<io_uring_cqe>(cq_ptr, params.cq_off.cqes);
+    }
+
+    ~statx_ring() { release(); }
+    statx_ring(statx_ring const&) = delete;
+    statx_ring& operator=(statx_ring const&) = delete;
+
+    void release() {
+        if (sqes != MAP_FAILED) ::munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) ::munmap(cq_ptr, cq_size);
+        if (sq_ptr != MAP_FAILED) ::munmap(sq_ptr, sq_size);
+        if (fd >= 0) ::close(fd);
+        sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        sq_ptr = cq_ptr = MAP_FAILED;
+        fd = -1;
+    }
+
+    bool ok() const { return fd >= 0; }
+
+    bool supports(unsigned const op) const {
+        constexpr unsigned ops = 256;
+        std::vector<unsigned char> buffer(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op));
+        auto probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, ops) < 0) return false;
+        return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+    unsigned capacity() const { return params.sq_entries; }
+
+    // statx(dirfd, names[i], AT_SYMLINK_NOFOLLOW, mask, &out[i]) for i < count <= capacity(), result codes in res.
+    // false if the batch has to be repeated with plain statx, the ring is released then
+    bool statx_batch(int const dirfd, char const* const* names, unsigned const count, unsigned const mask,
+                     struct statx* out, int* res) {
+        unsigned tail = *sq_tail;
+        for (unsigned i = 0; i < count; ++i, ++tail) {
+            auto idx = tail & *sq_mask;
+            auto sqe = &sqes[idx];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirfd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(names[i]);
+            sqe->len = mask;
+            sqe->off = reinterpret_cast<std::uint64_t>(&out[i]);
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+            sqe->user_data = i;
+            sq_array[idx] = idx;
+        }
+        std::atomic_ref<unsigned>(*sq_tail).store(tail, std::memory_order_release);
+
+        unsigned submitted = 0, completed = 0;
+        while (completed < count) {
+            auto n = ::syscall(__NR_io_uring_enter, fd, count - submitted, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                // the kernel still writes out[] for what it took, and what it left in the queue would go
+                // out with the next batch: wait for the first, then give the ring up for good
+                auto const err = errno;
+                while (completed < submitted) {
+                    if (::syscall(__NR_io_uring_enter, fd, 0, submitted - completed, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                        errno != EINTR)
+                        break;  // closing the ring cancels the rest
+                    completed += reap(res);
+                }
+                release();
+                errno = err;
+                return false;
+            }
+            submitted += static_cast<unsigned>(n);
+            completed += reap(res);
+        }
+        // the flags and mask are valid for statx, so these mean the ring cannot run it after all
+        for (unsigned i = 0; i < count; ++i)
+            if (res[i] == -EINVAL || res[i] == -EOPNOTSUPP) {
+                release();
+                return false;
+            }
+        return true;
+    }
+
+   private:
+    // copy the result codes of the completions so far into res, returns how many there were
+    unsigned reap(int* res) {
+        unsigned head = *cq_head, reaped = 0;
+        while (head != std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire)) {
+            auto const& cqe = cqes[head & *cq_mask];
+            res[cqe.user_data] = cqe.res;
+            ++head;
+            ++reaped;
+        }
+        std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+        return reaped;
+    }
+};
+
+class statx_scanner {
+    unsigned fields;
+    statx_ring ring;
+
+    static entry_kind kind_of_dtype(unsigned char const t) {
+        switch (t) {
+            case DT_DIR: return entry_kind::directory;
+            case DT_LNK: return entry_kind::symlink;
+            case DT_REG: return entry_kind::regular;
+            default: return entry_kind::other;
+        }
+    }
+    static entry_kind kind_of_mode(unsigned const mode) {
+        if (S_ISDIR(mode)) return entry_kind::directory;
+        if (S_ISLNK(mode)) return entry_kind::symlink;
+        if (S_ISREG(mode)) return entry_kind::regular;
+        return entry_kind::other;
+    }
+
+    unsigned statx_mask() const {
+        unsigned mask = 0;
+        if (fields & sf_size) mask |= STATX_SIZE;
+        if (fields & sf_mtime) mask |= STATX_MTIME;
+        return mask;
+    }
+
+   public:
+    explicit statx_scanner(unsigned const fields, bool const use_uring = true)
+        : fields(fields), ring(use_uring ? 256 : 0) {}
+
+    bool uses_uring() const { return ring.ok(); }
+
+    // call f(scan_entry const&) for every entry of the directory `name` (relative to parent_fd)
+    // returns false, with errno set, if the directory cannot be opened or read to the end
+    template <typename F>
+    bool scan(int const parent_fd, char const* name, F&& f) {
+        int dirfd = ::openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirfd < 0) return false;
+
+        std::vector<char> buffer(64 * 1024);
+        std::vector<scan_entry> batch;
+        std::vector<char const*> names;
+        std::vector<unsigned> need_stat;
+        std::vector<struct statx> stx;
+        std::vector<char const*> stat_names;
+        std::vector<int> res;
+        auto const base_mask = statx_mask();
+
+        for (;;) {
+            auto n = ::syscall(SYS_getdents64, dirfd, buffer.data(), buffer.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                auto const err = errno;
+                ::close(dirfd);
+                errno = err;
+                return false;
+            }
+            if (n == 0) break;
+
+            batch.clear();
+            names.clear();
+            need_stat.clear();
+            for (long pos = 0; pos < n;) {
+                auto d = reinterpret_cast<dirent64 const*>(buffer.data() + pos);
+                pos += d->d_reclen;
+                std::string_view entry_name(d->d_name);
+                if (entry_name == "." || entry_name == "..") continue;
+
+                batch.push_back({dirfd, entry_name, kind_of_dtype(d->d_type), 0, 0, 0});
+                names.push_back(d->d_name);
+                // d_type is DT_UNKNOWN on some filesystems, then statx has to tell the type
+                if (base_mask != 0 || d->d_type == DT_UNKNOWN) need_stat.push_back(static_cast<unsigned>(batch.size() - 1));
+            }
+
+            auto const mask = base_mask | STATX_TYPE;
+            stx.resize(need_stat.size());
+            res.assign(need_stat.size(), 0);
+            stat_names.resize(need_stat.size());
+            for (size_t i = 0; i < need_stat.size(); ++i) stat_names[i] = names[need_stat[i]];
+
+            // a failed batch releases the ring, the rest of the scan uses plain statx
+            bool done = false;
+            if (ring.ok()) {
+                done = true;
+                for (size_t first = 0; done && first < need_stat.size(); first += ring.capacity()) {
+                    auto count = static_cast<unsigned>(std::min<size_t>(ring.capacity(), need_stat.size() - first));
+                    done = ring.statx_batch(dirfd, stat_names.data() + first, count, mask, stx.data() + first, res.data() + first);
+                }
+            }
+            if (!done) {
+                for (size_t i = 0; i < need_stat.size(); ++i) {
+                    res[i] = ::statx(dirfd, stat_names[i], AT_SYMLINK_NOFOLLOW, mask, &stx[i]) == 0 ? 0 : -errno;
+                }
+            }
+
+            for (size_t i = 0; i < need_stat.size(); ++i) {
+                auto& e = batch[need_stat[i]];
+                if (res[i] < 0) {
+                    e.error = -res[i];  // ENOENT: removed meanwhile
+                    continue;
+                }
+                if (stx[i].stx_mask & STATX_TYPE) e.kind = kind_of_mode(stx[i].stx_mode);
+                if (stx[i].stx_mask & STATX_SIZE) e.size = stx[i].stx_size;
+                if (stx[i].stx_mask & STATX_MTIME) e.mtime = stx[i].stx_mtime.tv_sec;
+            }
+
+            for (auto const& e : batch) f(e);
+        }
+
+        ::close(dirfd);
+        return true;
+    }
+
+    template <typename F>
+    bool scan(fs::path const& dir, F&& f) {
+        return scan(AT_FDCWD, dir.c_str(), std::forward<F>(f));
+    }
+};
+
+// the output of visit_directory, listed by the statx scanner
+void visit_directory_statx(statx_scanner& scanner, int const parent_fd, char const* dir,
+                           bool const recursive = false, unsigned int const level = 0) {
+    auto lead = std::string(level * 3, ' ');
+    auto ok = scanner.scan(parent_fd, dir, [&](scan_entry const& e) {
+        auto filename = std::string(e.name);
+        if (e.error) std::cerr << std::quoted(filename) << ": " << std::strerror(e.error) << '\n';
+        if (e.kind == entry_kind::directory) {
+            std::cout << lead << "[+]" << std::quoted(filename) << '\n';
+            if (recursive)
+                visit_directory_statx(scanner, e.dirfd, filename.c_str(), recursive, level + 1);
+        } else if (e.kind == entry_kind::symlink)
+            std::cout << lead << "[>]" << std::quoted(filename) << '\n';
+        else if (e.kind == entry_kind::regular)
+            std::cout << lead << " " << std::quoted(filename) << '\n';
+        else
+            std::cout << lead << "[?]" << std::quoted(filename) << '\n';
+    });
+    if (!ok) std::cerr << std::quoted(dir) << ": " << std::strerror(errno) << '\n';
+}
+
+int main(int argc, char const* argv[]) {
+    auto path = argc > 1 ? fs::path(argv[1]) : fs::current_path() / "test";
+
+    // listing only needs the type, getdents64 alone answers it on most filesystems
+    {
+        statx_scanner scanner(sf_none);
+        visit_directory_statx(scanner, AT_FDCWD, path.c_str(), true);
+    }
+    // sizes for dir_size, statx only asks the filesystem for STATX_SIZE
+    {
+        statx_scanner scanner(sf_size);
+        std::uintmax_t total = 0;
+        auto walk = [&](auto& self, int const parent_fd, char const* dir) -> void {
+            scanner.scan(parent_fd, dir, [&](scan_entry const& e) {
+                if (e.error)
+                    std::cerr << std::quoted(std::string(e.name)) << ": " << std::strerror(e.error) << '\n';
+                else if (e.kind == entry_kind::directory)
+                    self(self, e.dirfd, std::string(e.name).c_str());
+                else if (e.kind == entry_kind::regular)
+                    total += e.size;
+            });
+        };
+        walk(walk, AT_FDCWD, path.c_str());
+        std::cout << "io_uring: " << std::boolalpha << scanner.uses_uring() << ", size: " << total << '\n';
+    }
+}
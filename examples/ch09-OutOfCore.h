@@ -0,0 +1,171 @@
+#pragma once
+
+// Map/reduce over files larger than RAM, read through mmap. POSIX only.
+
+#include <algorithm>  // std::min, std::max
+#include <cerrno>
+#include <cstddef>
+#include <numeric>  // std::transform_reduce, std::lcm
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>  // std::exchange
+#include <vector>
+
+#include <fcntl.h>  // open
+#include <sys/mman.h>  // mmap, madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // close, sysconf
+
+#include "ch09-ParallelUtils.h"
+
+namespace ParallelUtils {
+
+namespace out_of_core_detail {
+    [[noreturn]] inline void fail(std::string const& what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    class input_file {
+        int fd = -1;
+
+       public:
+        std::string path;
+        std::size_t size = 0;
+
+        explicit input_file(std::string p) : path(std::move(p)) {
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) fail("open " + path);
+            struct stat st {};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                fail("fstat " + path);
+            }
+            size = static_cast<std::size_t>(st.st_size);
+        }
+
+        input_file(input_file&& other) noexcept
+            : fd(std::exchange(other.fd, -1)), path(std::move(other.path)), size(other.size) {}
+
+        ~input_file() {
+            if (fd >= 0) ::close(fd);
+        }
+
+        int handle() const { return fd; }
+    };
+
+    // [offset, offset + length) of a file, mapped read-only; offset is a multiple of the page size
+    class mapped_window {
+        void* addr = nullptr;
+        std::size_t length = 0;
+
+       public:
+        std::size_t file = 0;
+        std::size_t offset = 0;
+
+        mapped_window(input_file const& in, std::size_t const file, std::size_t const offset, std::size_t const length)
+            : length(length), file(file), offset(offset) {
+            addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, in.handle(), static_cast<off_t>(offset));
+            if (addr == MAP_FAILED) fail("mmap " + in.path);
+            // read ahead aggressively, pages behind are not dropped but no longer look hot to reclaim;
+            // start reading the whole window now, so the disk works on it while the workers reduce
+            // the previous one. The mapping itself goes when the window is done
+            ::madvise(addr, length, MADV_SEQUENTIAL);
+            ::madvise(addr, length, MADV_WILLNEED);
+        }
+
+        mapped_window(mapped_window&& other) noexcept
+            : addr(std::exchange(other.addr, nullptr)), length(other.length), file(other.file), offset(other.offset) {}
+
+        mapped_window& operator=(mapped_window&& other) noexcept {
+            std::swap(addr, other.addr);
+            std::swap(length, other.length);
+            file = other.file;
+            offset = other.offset;
+            return *this;
+        }
+
+        ~mapped_window() {
+            if (addr != nullptr) ::munmap(addr, length);
+        }
+
+        std::byte const* data() const { return static_cast<std::byte const*>(addr); }
+        std::size_t size() const { return length; }
+    };
+}  // namespace out_of_core_detail
+
+struct out_of_core_options {
+    std::size_t window = std::size_t{256} << 20;  // bytes mapped at once, two windows are mapped at a time
+    std::size_t chunk = std::size_t{1} << 20;  // bytes per piece of work, both rounded to whole pages
+};
+
+// Reduce f(x) over every T stored in the files, in file order, without holding more than two windows
+// in memory. The next window is mapped and read ahead while the workers reduce the current one, in
+// chunks that start on page boundaries. After each window sink(path, first element, partial result)
+// is called in order, so results stream out while the rest is still being read. Every file must hold
+// whole T's, in the byte order of this machine.
+template <typename T, typename R, typename Reduce, typename Transform, typename Sink>
+R out_of_core_transform_reduce(std::vector<std::string> const& paths, R init, Reduce op, Transform f, Sink sink,
+                               out_of_core_options const& options = {}) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    using namespace out_of_core_detail;
+
+    auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto const unit = std::lcm(page, sizeof(T));  // a window or chunk always ends on a page and a T
+    auto const chunk = std::max(options.chunk / unit, std::size_t{1}) * unit;
+    auto const window = std::max(options.window / chunk, std::size_t{1}) * chunk;
+
+    std::vector<input_file> files;
+    for (auto const& path : paths) {
+        files.emplace_back(path);
+        if (files.back().size % sizeof(T) != 0) {
+            errno = EINVAL;
+            fail(path + " does not hold whole elements");
+        }
+    }
+
+    // the window at offset in file, or the first one of the next non-empty file
+    auto map_next = [&](std::size_t file, std::size_t offset) -> std::optional<mapped_window> {
+        for (; file < files.size(); ++file, offset = 0)
+            if (offset < files[file].size)
+                return mapped_window(files[file], file, offset, std::min(window, files[file].size - offset));
+        return std::nullopt;
+    };
+
+    auto& pool = thread_pool::current();
+    auto next = map_next(0, 0);
+    while (next) {
+        auto current = std::move(*next);
+        next = map_next(current.file, current.offset + current.size());
+
+        auto const first = reinterpret_cast<T const*>(current.data());
+        auto const count = current.size() / sizeof(T);
+        auto const per_chunk = chunk / sizeof(T);
+        // windows and chunks are never empty, each starts from its first element rather than R{}
+        auto reduce = [&](T const* from, T const* to) { return std::transform_reduce(from + 1, to, R(f(*from)), op, f); };
+        auto partial = pool.sequential(count)
+                           ? reduce(first, first + count)
+                           : pool.template reduce_range<R>(0, (count + per_chunk - 1) / per_chunk,
+                                 [&](std::size_t const lo, std::size_t const hi) {
+                                     return reduce(first + lo * per_chunk, first + std::min(hi * per_chunk, count));
+                                 }, op);
+
+        sink(files[current.file].path, current.offset / sizeof(T), partial);
+        init = op(std::move(init), std::move(partial));
+    }
+    return init;
+}
+
+template <typename T, typename R, typename Reduce, typename Transform>
+R out_of_core_transform_reduce(std::vector<std::string> const& paths, R init, Reduce op, Transform f,
+                               out_of_core_options const& options = {}) {
+    return out_of_core_transform_reduce<T>(paths, std::move(init), op, f, [](auto const&...) {}, options);
+}
+
+template <typename T, typename R, typename Reduce>
+R out_of_core_reduce(std::vector<std::string> const& paths, R init, Reduce op, out_of_core_options const& options = {}) {
+    return out_of_core_transform_reduce<T>(paths, std::move(init), op, [](T const& x) { return x; }, options);
+}
+
+}  // namespace ParallelUtils
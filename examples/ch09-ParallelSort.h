@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>  // std::sort
+#include <array>
+#include <bit>  // std::bit_cast
+#include <cstddef>
+#include <cstdint>
+#include <functional>  // std::identity
+#include <iterator>
+#include <memory>  // std::align, std::allocator, std::construct_at
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+
+namespace ParallelUtils {
+
+// Radix keys: the key of an element is an arithmetic value, or a fixed-width byte string
+// (std::array of char/unsigned char, compared byte by byte like memcmp), sorted 8 bits per pass.
+template <typename K>
+struct radix_key {
+    static_assert(std::is_arithmetic_v<K>, "radix keys are arithmetic or std::array<unsigned char, N>");
+    static constexpr std::size_t passes = sizeof(K);
+
+    // the same order as K, as an unsigned integer
+    static auto bits(K const key) {
+        if constexpr (std::is_integral_v<K>) {
+            using U = std::make_unsigned_t<K>;
+            auto u = static_cast<U>(key);
+            if constexpr (std::is_signed_v<K>) u ^= U(1) << (8 * sizeof(K) - 1);
+            return u;
+        } else {
+            using U = std::conditional_t<sizeof(K) == 4, std::uint32_t, std::uint64_t>;
+            auto u = std::bit_cast<U>(key);
+            auto const sign = U(1) << (8 * sizeof(K) - 1);
+            return (u & sign) != 0 ? static_cast<U>(~u) : static_cast<U>(u | sign);  // negatives reversed
+        }
+    }
+
+    // pass 0 is the least significant byte
+    static unsigned digit(K const key, std::size_t const pass) {
+        return static_cast<unsigned>((bits(key) >> (8 * pass)) & 0xFF);
+    }
+};
+
+template <typename C, std::size_t N>
+    requires(sizeof(C) == 1)
+struct radix_key<std::array<C, N>> {
+    static constexpr std::size_t passes = N;
+
+    static unsigned digit(std::array<C, N> const& key, std::size_t const pass) {
+        return static_cast<unsigned char>(key[N - 1 - pass]);
+    }
+};
+
+namespace sort_detail {
+    // fixed blocks, one per worker: the counts of block b describe exactly the elements block b scatters
+    template <typename F>
+    void for_each_block(thread_pool& pool, std::size_t const blocks, F&& f) {
+        if (blocks == 1)
+            f(std::size_t{0});
+        else
+            pool.for_range(0, blocks, [&](std::size_t const lo, std::size_t const hi) {
+                for (auto b = lo; b < hi; ++b) f(b);
+            });
+    }
+
+    // one row of counts per block, each starting on its own cache line, in one allocation:
+    // per_worker<std::vector> would pad the vector headers, not the counts the blocks write
+    class count_rows {
+        static constexpr std::size_t per_line = std::max<std::size_t>(cache_line / sizeof(std::size_t), 1);
+
+        std::size_t stride;
+        std::vector<std::size_t> storage;
+        std::size_t* base;
+
+       public:
+        count_rows(std::size_t const rows, std::size_t const width)
+            : stride((width + per_line - 1) / per_line * per_line), storage(rows * stride + per_line) {
+            void* p = storage.data();
+            auto space = storage.size() * sizeof(std::size_t);
+            base = static_cast<std::size_t*>(std::align(cache_line, rows * stride * sizeof(std::size_t), p, space));
+        }
+
+        count_rows(count_rows const&) = delete;
+        count_rows& operator=(count_rows const&) = delete;
+
+        std::size_t* operator[](std::size_t const row) { return base + row * stride; }
+    };
+
+    // room for n elements to scatter into, so T needs no default constructor: the first scatter
+    // move-constructs every element in place, later ones assign, and they are destroyed together.
+    // A move that throws halfway would leave no record of which elements exist, hence nothrow
+    template <typename T>
+    class scratch {
+        static_assert(std::is_nothrow_move_constructible_v<T>, "the sorts move-construct into uninitialized storage");
+
+        std::size_t count;
+        T* ptr;
+        bool built = false;
+
+       public:
+        explicit scratch(std::size_t const n) : count(n), ptr(std::allocator<T>().allocate(n)) {}
+
+        ~scratch() {
+            if (built) std::destroy_n(ptr, count);
+            std::allocator<T>().deallocate(ptr, count);
+        }
+
+        scratch(scratch const&) = delete;
+        scratch& operator=(scratch const&) = delete;
+
+        T* data() { return ptr; }
+
+        // put(i, x) for the element at i: construct on the first scatter, assign on the ones after
+        template <typename F>
+        void scatter(F&& f) {
+            if (built)
+                f([this](std::size_t const i, T&& x) { ptr[i] = std::move(x); });
+            else
+                f([this](std::size_t const i, T&& x) { std::construct_at(ptr + i, std::move(x)); });
+            built = true;
+        }
+    };
+
+    inline std::size_t block_count(thread_pool& pool, std::size_t const n) {
+        return n < (1 << 16) || (pool.size() == 1 && !pool.in_worker()) ? 1 : pool.size();
+    }
+}  // namespace sort_detail
+
+// Stable LSD radix sort by key(element), a byte per pass over contiguous elements.
+// Each pass counts digits per block in parallel, turns the counts into one write position per
+// block and digit, and moves every block to its positions in parallel; a pass whose byte is the
+// same for all elements is skipped. Needs a buffer as large as the input, but no default constructor.
+template <typename Iter, typename Key = std::identity>
+void parallel_radix_sort(Iter first, Iter last, Key key = {}) {
+    static_assert(std::contiguous_iterator<Iter>);
+    using T = std::iter_value_t<Iter>;
+    using K = std::remove_cvref_t<std::invoke_result_t<Key&, T const&>>;
+    using traits = radix_key<K>;
+
+    auto const n = static_cast<std::size_t>(last - first);
+    if (n < 2) return;
+
+    auto& pool = thread_pool::current();
+    auto const blocks = sort_detail::block_count(pool, n);
+    auto const block = (n + blocks - 1) / blocks;
+    auto range = [&](std::size_t const b) { return std::pair(std::min(b * block, n), std::min(b * block + block, n)); };
+
+    sort_detail::scratch<T> buffer(n);
+    T* from = std::to_address(first);
+    T* to = buffer.data();
+    per_worker<std::array<std::size_t, 256>> counts(blocks);
+
+    for (std::size_t pass = 0; pass < traits::passes; ++pass) {
+        sort_detail::for_each_block(pool, blocks, [&](std::size_t const b) {
+            auto& count = counts[b];
+            count.fill(0);
+            auto [lo, hi] = range(b);
+            for (auto i = lo; i < hi; ++i) ++count[traits::digit(key(from[i]), pass)];
+        });
+
+        bool trivial = false;
+        std::size_t offset = 0;
+        for (unsigned d = 0; d < 256; ++d)
+            for (std::size_t b = 0; b < blocks; ++b) {
+                auto c = counts[b][d];
+                trivial |= c == n;
+                counts[b][d] = offset;
+                offset += c;
+            }
+        if (trivial) continue;
+
+        auto scatter = [&](auto put) {
+            sort_detail::for_each_block(pool, blocks, [&](std::size_t const b) {
+                auto& position = counts[b];
+                auto [lo, hi] = range(b);
+                for (auto i = lo; i < hi; ++i) put(position[traits::digit(key(from[i]), pass)]++, std::move(from[i]));
+            });
+        };
+        if (to == buffer.data())
+            buffer.scatter(scatter);
+        else
+            scatter([&](std::size_t const i, T&& x) { to[i] = std::move(x); });
+        std::swap(from, to);
+    }
+
+    if (from != std::to_address(first))
+        sort_detail::for_each_block(pool, blocks, [&](std::size_t const b) {
+            auto [lo, hi] = range(b);
+            std::move(from + lo, from + hi, std::to_address(first) + lo);
+        });
+}
+
+// Sample sort for any strict weak ordering: splitters from a sorted random sample cut the input
+// into about four buckets per worker, the elements are moved to their buckets in parallel, and
+// every bucket is sorted with std::sort as its own task. Not stable. The elements equivalent to a
+// splitter get a bucket of their own that needs no sort, so a heavily repeated key, which is sure
+// to be sampled, ends up there instead of making one bucket as large as all its copies.
+template <typename Iter, typename Compare = std::less<>>
+void parallel_sort(Iter first, Iter last, Compare comp = {}) {
+    static_assert(std::random_access_iterator<Iter>);
+    using T = std::iter_value_t<Iter>;
+    auto const n = static_cast<std::size_t>(std::distance(first, last));
+    auto& pool = thread_pool::current();
+    auto const blocks = sort_detail::block_count(pool, n);
+    if (blocks == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    // splitters: every oversample-th element of a sorted random sample
+    std::size_t const buckets = pool.size() * 4;
+    std::size_t const oversample = 32;
+    std::vector<T> sample;
+    sample.reserve(buckets * oversample);
+    std::mt19937_64 gen(n);
+    std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+    for (std::size_t i = 0; i < buckets * oversample; ++i) sample.push_back(first[pick(gen)]);
+    std::sort(sample.begin(), sample.end(), comp);
+    std::vector<T> splitters;
+    for (std::size_t k = 1; k < buckets; ++k) splitters.push_back(std::move(sample[k * oversample]));
+    splitters.erase(std::unique(splitters.begin(), splitters.end(), [&](T const& a, T const& b) { return !comp(a, b); }),
+                    splitters.end());
+    auto const classes = 2 * splitters.size() + 1;
+
+    auto const block = (n + blocks - 1) / blocks;
+    auto range = [&](std::size_t const b) { return std::pair(std::min(b * block, n), std::min(b * block + block, n)); };
+
+    // bucket 2k holds the elements strictly between splitters[k - 1] and splitters[k],
+    // bucket 2k + 1 the ones equivalent to splitters[k]
+    std::vector<std::uint32_t> bucket_of(n);
+    sort_detail::count_rows counts(blocks, classes);
+    sort_detail::for_each_block(pool, blocks, [&](std::size_t const b) {
+        auto [lo, hi] = range(b);
+        for (auto i = lo; i < hi; ++i) {
+            auto j = static_cast<std::size_t>(std::upper_bound(splitters.begin(), splitters.end(), first[i], comp) -
+                                              splitters.begin());
+            auto k = j > 0 && !comp(splitters[j - 1], first[i]) ? 2 * j - 1 : 2 * j;
+            bucket_of[i] = static_cast<std::uint32_t>(k);
+            ++counts[b][k];
+        }
+    });
+
+    std::vector<std::size_t> bucket_begin(classes + 1);
+    std::size_t offset = 0;
+    for (std::size_t k = 0; k < classes; ++k) {
+        bucket_begin[k] = offset;
+        for (std::size_t b = 0; b < blocks; ++b) {
+            auto c = counts[b][k];
+            counts[b][k] = offset;
+            offset += c;
+        }
+    }
+    bucket_begin[classes] = n;
+
+    sort_detail::scratch<T> buffer(n);
+    buffer.scatter([&](auto put) {
+        sort_detail::for_each_block(pool, blocks, [&](std::size_t const b) {
+            auto position = counts[b];
+            auto [lo, hi] = range(b);
+            for (auto i = lo; i < hi; ++i) put(position[bucket_of[i]]++, std::move(first[i]));
+        });
+    });
+
+    pool.for_range(0, classes, [&](std::size_t const lo, std::size_t const hi) {
+        for (auto k = lo; k < hi; ++k) {
+            auto from = buffer.data() + bucket_begin[k];
+            auto to = buffer.data() + bucket_begin[k + 1];
+            if (k % 2 == 0) std::sort(from, to, comp);  // the odd buckets are all one key
+            std::move(from, to, std::next(first, bucket_begin[k]));
+        }
+    });
+}
+
+}  // namespace ParallelUtils
@@ -0,0 +1,1203 @@
+#pragma once
+
+#include <algorithm>  // std::transform
+#include <array>
+#include <atomic>
+#include <bit>  // std::popcount
+#include <cmath>  // std::ceil
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>  // std::exception_ptr
+#include <fstream>
+#include <functional>  // std::function
+#include <iterator>
+#include <limits>
+#include <memory>  // std::unique_ptr
+#include <mutex>
+#include <new>  // std::align_val_t, std::bad_array_new_length, std::hardware_destructive_interference_size
+#include <numeric>  // std::reduce
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>  // std::exchange
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>  // MPOL_INTERLEAVE
+#include <sched.h>  // sched_getaffinity
+#include <sys/syscall.h>  // SYS_mbind, SYS_get_mempolicy
+#include <unistd.h>  // syscall
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ParallelUtils {
+
+// CPUs this process may really use: affinity mask and cgroup CPU quota (containers), not just the host cores
+inline unsigned available_cpus() {
+    unsigned n = std::thread::hardware_concurrency();
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        n = static_cast<unsigned>(CPU_COUNT(&set));
+
+    auto limit = [&n](double quota, double period) {
+        if (quota > 0 && period > 0)
+            n = std::min(n, static_cast<unsigned>(std::ceil(quota / period)));
+    };
+    // cgroup v2: "max 100000" or "200000 100000"
+    if (std::ifstream f("/sys/fs/cgroup/cpu.max"); f) {
+        std::string quota;
+        double period = 0;
+        if (f >> quota >> period && quota != "max")
+            limit(std::stod(quota), period);
+    } else if (std::ifstream q("/sys/fs/cgroup/cpu/cpu.cfs_quota_us"), p("/sys/fs/cgroup/cpu/cpu.cfs_period_us"); q && p) {
+        // cgroup v1, quota is -1 when unlimited
+        double quota = 0, period = 0;
+        if (q >> quota && p >> period)
+            limit(quota, period);
+    }
+#endif
+    return std::max(n, 1u);
+}
+
+#ifdef __cpp_lib_hardware_interference_size
+// GCC warns that the value depends on -mtune; these headers are compiled with the program, not an ABI
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr std::size_t cache_line = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr std::size_t cache_line = 64;
+#endif
+
+// A value alone on its cache line: a worker writing it never invalidates the line a neighbour writes.
+template <typename T>
+struct alignas(cache_line) padded {
+    T value{};
+};
+
+// One padded slot per worker or per block for partial results. A plain std::vector<R> puts
+// eight long longs on one line, and every update by one worker stalls the seven others.
+template <typename T>
+class per_worker {
+    std::vector<padded<T>> slots;
+
+   public:
+    explicit per_worker(std::size_t const n, T const& init = T{}) : slots(n, padded<T>{init}) {}
+
+    T& operator[](std::size_t const i) { return slots[i].value; }
+    T const& operator[](std::size_t const i) const { return slots[i].value; }
+    std::size_t size() const { return slots.size(); }
+
+    template <typename R, typename F>
+    R combine(R init, F op) const {
+        for (auto const& slot : slots) init = op(std::move(init), slot.value);
+        return init;
+    }
+};
+
+// A unit of work that sits in a deque; run() must not touch the job after it reports completion.
+struct job {
+    void (*run)(job*);
+};
+
+// Chase-Lev deque: the owner pushes and takes at the bottom (newest first), thieves steal at the top (oldest,
+// usually the biggest piece of a recursive split). Memory orders follow Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models".
+class work_stealing_deque {
+    struct ring {
+        std::int64_t capacity;  // power of two
+        std::unique_ptr<std::atomic<job*>[]> slots;
+
+        explicit ring(std::int64_t const capacity)
+            : capacity(capacity), slots(new std::atomic<job*>[capacity]) {}
+
+        job* get(std::int64_t const i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t const i, job* j) { slots[i & (capacity - 1)].store(j, std::memory_order_relaxed); }
+    };
+
+    alignas(cache_line) std::atomic<std::int64_t> top{0};
+    alignas(cache_line) std::atomic<std::int64_t> bottom{0};
+    std::atomic<ring*> buffer;
+    std::vector<std::unique_ptr<ring>> rings;  // outgrown rings stay alive, a thief may still be reading one
+
+   public:
+    explicit work_stealing_deque(std::int64_t const capacity = 64) {
+        rings.push_back(std::make_unique<ring>(capacity));
+        buffer.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(job* j) {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+        auto r = buffer.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            auto bigger = std::make_unique<ring>(r->capacity * 2);
+            for (auto i = t; i < b; ++i) bigger->put(i, r->get(i));
+            r = bigger.get();
+            rings.push_back(std::move(bigger));
+            buffer.store(r, std::memory_order_release);
+        }
+        r->put(b, j);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only
+    job* take() {
+        auto b = bottom.load(std::memory_order_relaxed) - 1;
+        auto r = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        job* j = r->get(b);
+        if (t == b) {
+            // the last job, a thief may be taking it right now
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                j = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return j;
+    }
+
+    // any thread; nullptr when empty or when another thief won the race
+    job* steal() {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        job* j = buffer.load(std::memory_order_acquire)->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return j;
+    }
+
+    bool empty() const {
+        return top.load(std::memory_order_seq_cst) >= bottom.load(std::memory_order_seq_cst);
+    }
+};
+
+// Fixed set of workers started once and reused by every parallel call. Each worker owns a
+// work_stealing_deque; join() pushes one half on the local deque and idle workers steal it.
+// Calls from outside the pool are handed to a worker through a locked queue.
+class thread_pool {
+    struct worker {
+        thread_pool* pool;
+        std::uint32_t seed;
+        work_stealing_deque jobs;
+        std::thread thread;
+
+        worker(thread_pool* pool, std::uint32_t const seed) : pool(pool), seed(seed) {}
+    };
+
+    // join(): runs on the thread that pops or steals it, the joining frame owns it
+    template <typename F>
+    struct stack_job : job {
+        F& f;
+        std::exception_ptr error;
+        std::atomic<bool> done{false};
+
+        explicit stack_job(F& f) : job{&stack_job::execute}, f(f) {}
+
+        static void execute(job* j) {
+            auto self = static_cast<stack_job*>(j);
+            try {
+                self->f();
+            } catch (...) {
+                self->error = std::current_exception();
+            }
+            self->done.store(true, std::memory_order_release);
+        }
+    };
+
+    // in_pool(): a thread outside the pool sleeps on `finished` until a worker has run it
+    template <typename F>
+    struct injected_job : job {
+        thread_pool& pool;
+        F& f;
+        std::exception_ptr error;
+        bool done = false;  // guarded by pool.mtx
+
+        injected_job(thread_pool& pool, F& f) : job{&injected_job::execute}, pool(pool), f(f) {}
+
+        static void execute(job* j) {
+            auto self = static_cast<injected_job*>(j);
+            auto& pool = self->pool;
+            try {
+                self->f();
+            } catch (...) {
+                self->error = std::current_exception();
+            }
+            {
+                std::lock_guard lock(pool.mtx);
+                self->done = true;
+            }
+            pool.finished.notify_all();
+        }
+    };
+
+    // submit(): fire and forget
+    struct heap_job : job {
+        std::function<void()> f;
+
+        explicit heap_job(std::function<void()> f) : job{&heap_job::execute}, f(std::move(f)) {}
+
+        static void execute(job* j) {
+            std::unique_ptr<heap_job> self(static_cast<heap_job*>(j));
+            self->f();
+        }
+    };
+
+    std::vector<std::unique_ptr<worker>> workers;
+    std::deque<job*> injected;  // guarded by mtx
+    std::atomic<std::size_t> injected_size{0};
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::atomic<unsigned> sleeping{0};
+    std::uint64_t epoch = 0;  // guarded by mtx, bumped whenever new work may wake a sleeper
+    bool stopping = false;
+
+    static inline thread_local worker* this_worker = nullptr;
+
+    worker* local() const { return this_worker != nullptr && this_worker->pool == this ? this_worker : nullptr; }
+
+    void inject(job* j) {
+        {
+            std::lock_guard lock(mtx);
+            injected.push_back(j);
+            injected_size.fetch_add(1, std::memory_order_relaxed);
+            ++epoch;
+        }
+        wake.notify_one();
+    }
+
+    // after a push to a deque: wake a worker only if one is asleep, pairs with the fence in worker_loop
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) == 0) return;
+        {
+            std::lock_guard lock(mtx);
+            ++epoch;
+        }
+        wake.notify_one();
+    }
+
+    job* steal(worker& me) {
+        auto n = workers.size();
+        me.seed ^= me.seed << 13;
+        me.seed ^= me.seed >> 17;
+        me.seed ^= me.seed << 5;
+        for (std::size_t k = 0, start = me.seed % n; k < n; ++k) {
+            auto& victim = *workers[(start + k) % n];
+            if (&victim == &me) continue;
+            if (auto j = victim.jobs.steal()) return j;
+        }
+        return nullptr;
+    }
+
+    job* find_work(worker& me) {
+        if (auto j = me.jobs.take()) return j;
+        if (auto j = steal(me)) return j;
+        if (injected_size.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard lock(mtx);
+        if (injected.empty()) return nullptr;
+        auto j = injected.front();
+        injected.pop_front();
+        injected_size.fetch_sub(1, std::memory_order_relaxed);
+        return j;
+    }
+
+    bool has_work() const {
+        if (!injected.empty()) return true;
+        for (auto const& w : workers)
+            if (!w->jobs.empty()) return true;
+        return false;
+    }
+
+    void worker_loop(worker& me) {
+        this_worker = &me;
+        for (int idle = 0;;) {
+            if (auto j = find_work(me)) {
+                j->run(j);
+                idle = 0;
+                continue;
+            }
+            if (++idle < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle = 0;
+
+            std::unique_lock lock(mtx);
+            if (stopping) return;
+            auto e = epoch;
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!has_work())
+                wake.wait(lock, [&] { return stopping || epoch != e; });
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // an explicit grain, or the one that stops the splitting at about 8 pieces per worker
+    std::size_t grain_for(std::size_t const n, std::size_t const grain) const {
+        return grain != 0 ? grain : std::max<std::size_t>(n / (std::size_t{workers.size()} * 8), 1);
+    }
+
+   public:
+    explicit thread_pool(unsigned const thread_nums = available_cpus()) {
+        workers.reserve(thread_nums);
+        for (unsigned i = 0; i < thread_nums; ++i)
+            workers.push_back(std::make_unique<worker>(this, 2654435761u * (i + 1)));
+        // every deque exists before any worker starts stealing
+        for (auto& w : workers)
+            w->thread = std::thread([this, &w = *w] { worker_loop(w); });
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(mtx);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w->thread.join();
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    // started on first use, shared by all parallel algorithms
+    static thread_pool& instance() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    // the pool the parallel algorithms run on: the caller's own pool on a worker, otherwise instance(),
+    // so pool.in_pool([&] { parallel_map(...); }) runs an algorithm on a pool of another size
+    static thread_pool& current() { return this_worker != nullptr ? *this_worker->pool : instance(); }
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // true on a worker of this pool, i.e. inside a parallel algorithm
+    bool in_worker() const { return local() != nullptr; }
+
+    // without a grain, below this many elements a parallel algorithm loops on the calling thread,
+    // splitting costs more than it saves
+    static constexpr std::size_t sequential_cutoff = 10'000;
+
+    // whether a parallel algorithm over n elements should just loop: too few of them to split, or a
+    // pool of one worker that the caller is not part of. An explicit grain says what is worth a task,
+    // so then only a range that cannot be split in two such pieces stays on the calling thread
+    bool sequential(std::size_t const n, std::size_t const grain = 0) const {
+        return (grain == 0 ? n < sequential_cutoff : n < 2 * grain) || (size() == 1 && !in_worker());
+    }
+
+    void submit(std::function<void()> task) { inject(new heap_job(std::move(task))); }
+
+    // run j on a worker without allocating: the caller's own deque on a worker, where it can be stolen,
+    // otherwise the shared queue; j must stay alive until it has run
+    void post(job* j) {
+        if (auto me = local()) {
+            me->jobs.push(j);
+            notify();
+        } else {
+            inject(j);
+        }
+    }
+
+    // run f on a worker and wait; inline when already on one
+    template <typename F>
+    void in_pool(F&& f) {
+        if (local() != nullptr) {
+            f();
+            return;
+        }
+        injected_job<std::remove_reference_t<F>> j(*this, f);
+        inject(&j);
+        {
+            std::unique_lock lock(mtx);
+            finished.wait(lock, [&] { return j.done; });
+        }
+        if (j.error) std::rethrow_exception(j.error);
+    }
+
+    // run a and b, possibly in parallel, and return when both are done
+    // b is offered to thieves while the caller runs a; if nobody took it the caller runs it too,
+    // otherwise the caller steals other work until b is finished, so nesting never blocks a worker
+    template <typename A, typename B>
+    void join(A&& a, B&& b) {
+        auto me = local();
+        if (me == nullptr) {
+            in_pool([&] { join(a, b); });
+            return;
+        }
+
+        stack_job<std::remove_reference_t<B>> right(b);
+        me->jobs.push(&right);
+        notify();
+
+        std::exception_ptr error;
+        try {
+            a();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        while (!right.done.load(std::memory_order_acquire)) {
+            // above `right` there are only jobs posted while a() ran, take() reaches `right` after them
+            if (auto j = me->jobs.take()) {
+                j->run(j);
+                continue;
+            }
+            if (auto j = steal(*me))
+                j->run(j);
+            else
+                std::this_thread::yield();
+        }
+
+        if (error) std::rethrow_exception(error);
+        if (right.error) std::rethrow_exception(right.error);
+    }
+
+    // f(lo, hi) over sub-ranges of [first, last), none shorter than grain unless the whole range is
+    //
+    // The range is split in halves about log2(size()) deep, one piece per worker. A piece that was
+    // stolen means some worker ran dry, so the thief may split it again: the grain adapts to where
+    // the load actually is, and skewed element costs or nested calls still keep every worker busy.
+    // grain 0 stops the splitting at about 8 pieces per worker.
+    template <typename F>
+    void for_range(std::size_t const first, std::size_t const last, F&& f, std::size_t const grain = 0) {
+        if (last <= first) return;
+        auto const min = 2 * grain_for(last - first, grain);
+        auto split = [&](auto& self, std::size_t lo, std::size_t hi, unsigned splits, worker* owner) -> void {
+            auto me = local();
+            if (me != owner) splits = std::max(splits / 2, size());
+            if (splits > 0 && hi - lo >= min) {
+                auto mid = lo + (hi - lo) / 2;
+                splits /= 2;
+                join([&] { self(self, lo, mid, splits, me); },
+                     [&] { self(self, mid, hi, splits, me); });
+            } else {
+                f(lo, hi);
+            }
+        };
+        in_pool([&] { split(split, first, last, size(), local()); });
+    }
+
+    // combine(leaf(lo, hi)...) over sub-ranges of [first, last), split like for_range; leaf never gets an
+    // empty one, so it can start from the element at lo. R{} for an empty range
+    template <typename R, typename Leaf, typename Combine>
+    R reduce_range(std::size_t const first, std::size_t const last, Leaf&& leaf, Combine&& combine,
+                   std::size_t const grain = 0) {
+        if (last <= first) return R{};
+        auto const min = 2 * grain_for(last - first, grain);
+        auto split = [&](auto& self, std::size_t lo, std::size_t hi, unsigned splits, worker* owner) -> R {
+            auto me = local();
+            if (me != owner) splits = std::max(splits / 2, size());
+            if (splits > 0 && hi - lo >= min) {
+                auto mid = lo + (hi - lo) / 2;
+                splits /= 2;
+                // the two halves are usually written by different workers
+                padded<R> left, right;
+                join([&] { left.value = self(self, lo, mid, splits, me); },
+                     [&] { right.value = self(self, mid, hi, splits, me); });
+                return combine(std::move(left.value), std::move(right.value));
+            }
+            return leaf(lo, hi);
+        };
+        R result{};
+        in_pool([&] { result = split(split, first, last, size(), local()); });
+        return result;
+    }
+};
+
+template <typename A, typename B>
+void join(A&& a, B&& b) {
+    thread_pool::current().join(std::forward<A>(a), std::forward<B>(b));
+}
+
+// Exact sums and prefix sums of arithmetic arrays with SSE2, which every x86-64 build has; scalar elsewhere.
+// Sums of 8 to 32-bit integers never overflow the 64-bit result, 64-bit ones wrap like std::reduce;
+// floating sums keep several independent accumulators so the adds do not wait on each other.
+namespace simd {
+
+#ifdef __SSE2__
+namespace detail {
+    inline std::int64_t hsum_epi64(__m128i v) {
+        alignas(16) std::int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+        return lanes[0] + lanes[1];
+    }
+
+    // signed 32-bit lanes to two 64-bit halves, added to acc
+    inline __m128i add_epi32_as_epi64(__m128i acc, __m128i v) {
+        auto sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+
+    // psadbw against zero: the 8 bytes of each half summed into a 64-bit lane
+    inline std::uint64_t sum_bytes(std::uint8_t const* p, std::size_t const n, __m128i const bias) {
+        auto zero = _mm_setzero_si128();
+        __m128i acc[4] = {zero, zero, zero, zero};
+        std::size_t i = 0;
+        for (; i + 64 <= n; i += 64)
+            for (int k = 0; k < 4; ++k) {
+                auto x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i + 16 * k)), bias);
+                acc[k] = _mm_add_epi64(acc[k], _mm_sad_epu8(x, zero));
+            }
+        for (; i + 16 <= n; i += 16) {
+            auto x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)), bias);
+            acc[0] = _mm_add_epi64(acc[0], _mm_sad_epu8(x, zero));
+        }
+        auto total = static_cast<std::uint64_t>(
+            hsum_epi64(_mm_add_epi64(_mm_add_epi64(acc[0], acc[1]), _mm_add_epi64(acc[2], acc[3]))));
+        auto const b = static_cast<std::uint8_t>(_mm_cvtsi128_si32(bias));
+        for (; i < n; ++i) total += static_cast<std::uint8_t>(p[i] ^ b);
+        return total;
+    }
+
+    // pmaddwd by ones: adjacent signed 16-bit pairs widened into 32-bit lanes,
+    // which are spilled into 64-bit ones before they can overflow
+    inline std::int64_t sum_words(std::int16_t const* p, std::size_t const n, __m128i const bias) {
+        auto const ones = _mm_set1_epi16(1);
+        auto wide = _mm_setzero_si128();
+        std::size_t i = 0;
+        while (i + 8 <= n) {
+            // a lane grows by at most 2^16 per step, 2^14 steps stay below 2^31
+            auto narrow = _mm_setzero_si128();
+            for (int step = 0; step < (1 << 14) && i + 8 <= n; ++step, i += 8) {
+                auto x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)), bias);
+                narrow = _mm_add_epi32(narrow, _mm_madd_epi16(x, ones));
+            }
+            wide = add_epi32_as_epi64(wide, narrow);
+        }
+        auto total = hsum_epi64(wide);
+        auto const b = static_cast<std::int16_t>(_mm_cvtsi128_si32(bias));
+        for (; i < n; ++i) total += static_cast<std::int16_t>(p[i] ^ b);
+        return total;
+    }
+}  // namespace detail
+
+inline std::uint64_t sum(std::uint8_t const* p, std::size_t const n) {
+    return detail::sum_bytes(p, n, _mm_setzero_si128());
+}
+
+// biased by 0x80 to unsigned, unbiased at the end
+inline std::int64_t sum(std::int8_t const* p, std::size_t const n) {
+    auto biased = detail::sum_bytes(reinterpret_cast<std::uint8_t const*>(p), n, _mm_set1_epi8(-128));
+    return static_cast<std::int64_t>(biased) - 128 * static_cast<std::int64_t>(n);
+}
+
+inline std::int64_t sum(std::int16_t const* p, std::size_t const n) {
+    return detail::sum_words(p, n, _mm_setzero_si128());
+}
+
+// biased by 0x8000 to signed, unbiased at the end
+inline std::uint64_t sum(std::uint16_t const* p, std::size_t const n) {
+    auto biased = detail::sum_words(reinterpret_cast<std::int16_t const*>(p), n, _mm_set1_epi16(-32768));
+    return static_cast<std::uint64_t>(biased + 32768 * static_cast<std::int64_t>(n));
+}
+
+inline std::int64_t sum(std::int32_t const* p, std::size_t const n) {
+    auto acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = detail::add_epi32_as_epi64(acc0, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)));
+        acc1 = detail::add_epi32_as_epi64(acc1, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i + 4)));
+    }
+    auto total = detail::hsum_epi64(_mm_add_epi64(acc0, acc1));
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+inline std::uint64_t sum(std::uint32_t const* p, std::size_t const n) {
+    auto const zero = _mm_setzero_si128();
+    auto acc0 = zero, acc1 = zero;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(x, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(x, zero));
+    }
+    auto total = static_cast<std::uint64_t>(detail::hsum_epi64(_mm_add_epi64(acc0, acc1)));
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+inline std::int64_t sum(std::int64_t const* p, std::size_t const n) {
+    auto const zero = _mm_setzero_si128();
+    __m128i acc[4] = {zero, zero, zero, zero};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (int k = 0; k < 4; ++k)
+            acc[k] = _mm_add_epi64(acc[k], _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i + 2 * k)));
+    auto total = detail::hsum_epi64(_mm_add_epi64(_mm_add_epi64(acc[0], acc[1]), _mm_add_epi64(acc[2], acc[3])));
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+// unsigned lanes wrap exactly like the signed ones
+inline std::uint64_t sum(std::uint64_t const* p, std::size_t const n) {
+    return static_cast<std::uint64_t>(sum(reinterpret_cast<std::int64_t const*>(p), n));
+}
+
+inline float sum(float const* p, std::size_t const n) {
+    __m128 acc[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        for (int k = 0; k < 4; ++k) acc[k] = _mm_add_ps(acc[k], _mm_loadu_ps(p + i + 4 * k));
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(_mm_add_ps(acc[0], acc[1]), _mm_add_ps(acc[2], acc[3])));
+    float total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+inline double sum(double const* p, std::size_t const n) {
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (int k = 0; k < 4; ++k) acc[k] = _mm_add_pd(acc[k], _mm_loadu_pd(p + i + 2 * k));
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(_mm_add_pd(acc[0], acc[1]), _mm_add_pd(acc[2], acc[3])));
+    double total = lanes[0] + lanes[1];
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+
+// floats summed in double, like std::reduce(first, last, 0.0)
+inline double sum_as_double(float const* p, std::size_t const n) {
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto lo = _mm_loadu_ps(p + i), hi = _mm_loadu_ps(p + i + 4);
+        acc[0] = _mm_add_pd(acc[0], _mm_cvtps_pd(lo));
+        acc[1] = _mm_add_pd(acc[1], _mm_cvtps_pd(_mm_movehl_ps(lo, lo)));
+        acc[2] = _mm_add_pd(acc[2], _mm_cvtps_pd(hi));
+        acc[3] = _mm_add_pd(acc[3], _mm_cvtps_pd(_mm_movehl_ps(hi, hi)));
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(_mm_add_pd(acc[0], acc[1]), _mm_add_pd(acc[2], acc[3])));
+    double total = lanes[0] + lanes[1];
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+#else
+// scalar: 64-bit accumulators for integers, four independent chains for floating point
+template <typename T>
+auto sum(T const* p, std::size_t const n) {
+    if constexpr (std::is_integral_v<T>) {
+        std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t> total = 0;
+        for (std::size_t i = 0; i < n; ++i) total += p[i];
+        return total;
+    } else {
+        T acc[4] = {};
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            for (int k = 0; k < 4; ++k) acc[k] += p[i + k];
+        T total = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        for (; i < n; ++i) total += p[i];
+        return total;
+    }
+}
+
+inline double sum_as_double(float const* p, std::size_t const n) {
+    double acc[4] = {};
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (int k = 0; k < 4; ++k) acc[k] += p[i + k];
+    double total = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    for (; i < n; ++i) total += p[i];
+    return total;
+}
+#endif
+
+namespace detail {
+    template <std::size_t Size, bool Signed>
+    struct sized_int : std::type_identity<void> {};
+    template <>
+    struct sized_int<1, true> : std::type_identity<std::int8_t> {};
+    template <>
+    struct sized_int<1, false> : std::type_identity<std::uint8_t> {};
+    template <>
+    struct sized_int<2, true> : std::type_identity<std::int16_t> {};
+    template <>
+    struct sized_int<2, false> : std::type_identity<std::uint16_t> {};
+    template <>
+    struct sized_int<4, true> : std::type_identity<std::int32_t> {};
+    template <>
+    struct sized_int<4, false> : std::type_identity<std::uint32_t> {};
+    template <>
+    struct sized_int<8, true> : std::type_identity<std::int64_t> {};
+    template <>
+    struct sized_int<8, false> : std::type_identity<std::uint64_t> {};
+
+    // the fixed-width type the kernels take for T: an integer by its size and signedness, so char,
+    // long and long long find theirs whichever of them std::int64_t and friends happen to name
+    template <typename T>
+    using kernel_t = typename std::conditional_t<std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                                                 sized_int<sizeof(T), std::is_signed_v<T>>, std::type_identity<T>>::type;
+}  // namespace detail
+
+template <typename T>
+concept summable = (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_void_v<detail::kernel_t<T>>) ||
+                   std::same_as<T, float> || std::same_as<T, double>;
+
+// std::reduce(first, last, init, std::plus<>()) through a kernel when one fits: contiguous
+// elements with a kernel above, and an integral R for integers or a floating R for floating point
+template <typename Iter, typename R, typename F>
+R reduce(Iter first, Iter last, R init, F op) {
+    using T = std::remove_cv_t<std::iter_value_t<Iter>>;
+    using K = detail::kernel_t<T>;
+
+    if constexpr (std::same_as<F, std::plus<>> && std::contiguous_iterator<Iter> && summable<T> &&
+                  std::is_arithmetic_v<R> && std::is_integral_v<R> == std::is_integral_v<K>) {
+        auto p = reinterpret_cast<K const*>(std::to_address(first));
+        auto n = static_cast<std::size_t>(last - first);
+        if constexpr (std::same_as<K, float> && !std::same_as<R, float>)
+            return static_cast<R>(init + sum_as_double(p, n));
+        else
+            return static_cast<R>(init + sum(p, n));
+    } else {
+        return std::reduce(first, last, init, op);
+    }
+}
+
+// Prefix sums of 32/64-bit integers, float and double: the lanes of a register are scanned in
+// log2(lanes) shifted adds, and a broadcast carry links one register to the next.
+#ifdef __SSE2__
+namespace detail {
+    template <typename T>
+    struct lanes;
+
+    template <>
+    struct lanes<std::int32_t> {
+        using reg = __m128i;
+        static constexpr std::size_t width = 4;
+        static reg load(std::int32_t const* p) { return _mm_loadu_si128(reinterpret_cast<reg const*>(p)); }
+        static void store(std::int32_t* p, reg x) { _mm_storeu_si128(reinterpret_cast<reg*>(p), x); }
+        static reg set1(std::int32_t const v) { return _mm_set1_epi32(v); }
+        static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+        static reg shift1(reg x) { return _mm_slli_si128(x, 4); }
+        static reg shift2(reg x) { return _mm_slli_si128(x, 8); }
+        static reg prefix(reg x) {
+            x = add(x, shift1(x));
+            return add(x, shift2(x));
+        }
+        static reg last(reg x) { return _mm_shuffle_epi32(x, 0xFF); }
+        static std::int32_t first(reg x) { return _mm_cvtsi128_si32(x); }
+    };
+
+    template <>
+    struct lanes<std::int64_t> {
+        using reg = __m128i;
+        static constexpr std::size_t width = 2;
+        static reg load(std::int64_t const* p) { return _mm_loadu_si128(reinterpret_cast<reg const*>(p)); }
+        static void store(std::int64_t* p, reg x) { _mm_storeu_si128(reinterpret_cast<reg*>(p), x); }
+        static reg set1(std::int64_t const v) { return _mm_set1_epi64x(v); }
+        static reg add(reg a, reg b) { return _mm_add_epi64(a, b); }
+        static reg shift1(reg x) { return _mm_slli_si128(x, 8); }
+        static reg prefix(reg x) { return add(x, _mm_slli_si128(x, 8)); }
+        static reg last(reg x) { return _mm_unpackhi_epi64(x, x); }
+        static std::int64_t first(reg x) { return _mm_cvtsi128_si64(x); }
+    };
+
+    template <>
+    struct lanes<float> {
+        using reg = __m128;
+        static constexpr std::size_t width = 4;
+        static reg load(float const* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, reg x) { _mm_storeu_ps(p, x); }
+        static reg set1(float const v) { return _mm_set1_ps(v); }
+        static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+        static reg shift1(reg x) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)); }
+        static reg shift2(reg x) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)); }
+        static reg prefix(reg x) {
+            x = add(x, shift1(x));
+            return add(x, shift2(x));
+        }
+        static reg last(reg x) { return _mm_shuffle_ps(x, x, 0xFF); }
+        static float first(reg x) { return _mm_cvtss_f32(x); }
+    };
+
+    template <>
+    struct lanes<double> {
+        using reg = __m128d;
+        static constexpr std::size_t width = 2;
+        static reg load(double const* p) { return _mm_loadu_pd(p); }
+        static void store(double* p, reg x) { _mm_storeu_pd(p, x); }
+        static reg set1(double const v) { return _mm_set1_pd(v); }
+        static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+        static reg shift1(reg x) { return _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x), 8)); }
+        static reg prefix(reg x) { return add(x, shift1(x)); }
+        static reg last(reg x) { return _mm_unpackhi_pd(x, x); }
+        static double first(reg x) { return _mm_cvtsd_f64(x); }
+    };
+}  // namespace detail
+
+// out[i] = carry + in[0] + ... + in[i] (inclusive) or + in[i - 1] (exclusive), returns carry + all of in;
+// out may be in
+template <typename T>
+T scan(T const* in, T* out, std::size_t const n, T const carry, bool const inclusive) {
+    using L = detail::lanes<T>;
+    auto c = L::set1(carry);
+    std::size_t i = 0;
+    for (; i + L::width <= n; i += L::width) {
+        auto p = L::prefix(L::load(in + i));
+        L::store(out + i, L::add(c, inclusive ? p : L::shift1(p)));
+        c = L::add(c, L::last(p));
+    }
+    T acc = L::first(c);
+    for (; i < n; ++i) {
+        auto x = in[i];
+        if (inclusive) {
+            acc += x;
+            out[i] = acc;
+        } else {
+            out[i] = acc;
+            acc += x;
+        }
+    }
+    return acc;
+}
+#else
+template <typename T>
+T scan(T const* in, T* out, std::size_t const n, T carry, bool const inclusive) {
+    for (std::size_t i = 0; i < n; ++i) {
+        auto x = in[i];
+        if (inclusive) {
+            carry += x;
+            out[i] = carry;
+        } else {
+            out[i] = carry;
+            carry += x;
+        }
+    }
+    return carry;
+}
+#endif
+
+template <typename T>
+concept scannable = (std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 4 || sizeof(T) == 8)) ||
+                    std::same_as<T, float> || std::same_as<T, double>;
+
+// one block of a scan: through a kernel for std::plus<> over contiguous T -> T, in order otherwise;
+// without a carry (first block of an inclusive scan without init) the block starts from its first element
+template <typename InIt, typename OutIt, typename T, typename F>
+T scan_block(InIt first, InIt last, OutIt d_first, T const* carry, F op, bool const inclusive) {
+    using In = std::remove_cv_t<std::iter_value_t<InIt>>;
+
+    if constexpr (std::same_as<F, std::plus<>> && std::contiguous_iterator<InIt> && std::contiguous_iterator<OutIt> &&
+                  std::same_as<In, T> && std::same_as<std::iter_value_t<OutIt>, T> && scannable<T>) {
+        // unsigned lanes wrap exactly like the signed ones
+        using K = detail::kernel_t<typename std::conditional_t<std::is_integral_v<T>, std::make_signed<T>,
+                                                               std::type_identity<T>>::type>;
+        auto n = static_cast<std::size_t>(last - first);
+        auto c = static_cast<K>(carry != nullptr ? *carry : T{});
+        return static_cast<T>(scan(reinterpret_cast<K const*>(std::to_address(first)),
+                                   reinterpret_cast<K*>(std::to_address(d_first)), n, c, inclusive));
+    } else {
+        if (first == last) return carry != nullptr ? *carry : T{};
+        T acc = carry != nullptr ? *carry : T(*first);
+        if (carry == nullptr) {
+            *d_first = acc;  // inclusive only
+            ++first, ++d_first;
+        }
+        for (; first != last; ++first, ++d_first) {
+            T x = *first;  // before the write, d_first may be first
+            if (inclusive) {
+                acc = op(std::move(acc), x);
+                *d_first = acc;
+            } else {
+                *d_first = acc;
+                acc = op(std::move(acc), x);
+            }
+        }
+        return acc;
+    }
+}
+
+}  // namespace simd
+
+// grain: fewest elements worth a task of their own, the default lets the pool decide
+template <typename Iter, typename F>
+void parallel_map(Iter begin, Iter end, F f, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain))
+        std::transform(begin, end, begin, f);
+    else
+        pool.for_range(0, size, [&](std::size_t const lo, std::size_t const hi) {
+            auto first = std::next(begin, lo);
+            auto last = std::next(first, hi - lo);
+            std::transform(first, last, first, f);
+        }, grain);
+}
+
+// with std::plus<> over contiguous integers, float or double the chunks go through simd::reduce
+template <typename Iter, typename R, typename F>
+auto parallel_reduce(Iter begin, Iter end, R init, F op, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain))
+        return simd::reduce(begin, end, init, op);
+
+    auto value = pool.template reduce_range<R>(0, size, [&](std::size_t const lo, std::size_t const hi) {
+        auto first = std::next(begin, lo);
+        return simd::reduce(std::next(first), std::next(first, hi - lo), R(*first), op);
+    }, op, grain);
+    return op(init, value);
+}
+
+// map and reduce in one pass: each element is read once and never written back,
+// parallel_map followed by parallel_reduce reads everything twice and writes it once
+template <typename Iter, typename R, typename Reduce, typename Transform>
+R parallel_transform_reduce(Iter begin, Iter end, R init, Reduce op, Transform f, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain))
+        return std::transform_reduce(begin, end, init, op, f);
+
+    auto value = pool.template reduce_range<R>(0, size, [&](std::size_t const lo, std::size_t const hi) {
+        auto first = std::next(begin, lo);
+        return std::transform_reduce(std::next(first), std::next(first, hi - lo), R(f(*first)), op, f);
+    }, op, grain);
+    return op(init, value);
+}
+
+// parallel_map then parallel_reduce when the mapped values are needed too:
+// the reduce consumes each value while it is still in a register
+template <typename Iter, typename F, typename R, typename Reduce>
+R parallel_map_reduce(Iter begin, Iter end, F f, R init, Reduce op, std::size_t const grain = 0) {
+    auto leaf = [&](Iter first, Iter last, R value) {
+        for (; first != last; ++first) {
+            *first = f(*first);
+            value = op(std::move(value), *first);
+        }
+        return value;
+    };
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain))
+        return leaf(begin, end, std::move(init));
+
+    auto value = pool.template reduce_range<R>(0, size, [&](std::size_t const lo, std::size_t const hi) {
+        auto first = std::next(begin, lo);
+        *first = f(*first);
+        return leaf(std::next(first), std::next(first, hi - lo), R(*first));
+    }, op, grain);
+    return op(init, value);
+}
+
+// Two passes over about four blocks per worker: the block sums are reduced in parallel and
+// chained in order into one carry per block, then every block is scanned in parallel from its
+// carry through simd::scan_block. The input is read twice and the output written once.
+template <typename InIt, typename OutIt, typename T, typename F>
+OutIt blocked_scan(InIt first, InIt last, OutIt d_first, std::optional<T> const& init, F op, bool const inclusive) {
+    auto size = static_cast<std::size_t>(std::distance(first, last));
+    auto& pool = thread_pool::current();
+    constexpr std::size_t min_block = 4096;
+
+    if (size < 2 * min_block || (pool.size() == 1 && !pool.in_worker())) {
+        simd::scan_block(first, last, d_first, init ? &*init : nullptr, op, inclusive);
+        return std::next(d_first, size);
+    }
+
+    auto block = (size + pool.size() * 4 - 1) / (pool.size() * 4);
+    block = std::max(block, min_block);
+    auto blocks = (size + block - 1) / block;
+    auto block_begin = [&](std::size_t const b) { return std::next(first, b * block); };
+    auto block_size = [&](std::size_t const b) { return std::min(block, size - b * block); };
+
+    // written once per block, padding them would only spread the sums over more lines
+    std::vector<T> sums(blocks);
+    pool.for_range(0, blocks, [&](std::size_t const lo, std::size_t const hi) {
+        for (auto b = lo; b < hi; ++b) {
+            auto from = block_begin(b);
+            auto to = std::next(from, block_size(b));
+            sums[b] = simd::reduce(std::next(from), to, T(*from), op);
+        }
+    });
+
+    // carries[b]: init and every block before b; block 0 has none without init
+    std::vector<T> carries(blocks);
+    std::optional<T> acc = init;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        if (acc) carries[b] = *acc;
+        acc = acc ? op(*acc, sums[b]) : sums[b];
+    }
+
+    pool.for_range(0, blocks, [&](std::size_t const lo, std::size_t const hi) {
+        for (auto b = lo; b < hi; ++b) {
+            auto from = block_begin(b);
+            simd::scan_block(from, std::next(from, block_size(b)), std::next(d_first, b * block),
+                             b == 0 && !init ? nullptr : &carries[b], op, inclusive);
+        }
+    });
+    return std::next(d_first, size);
+}
+
+// the parallel std::inclusive_scan / std::exclusive_scan, op must be associative;
+// d_first may be first for an in-place scan
+template <typename InIt, typename OutIt, typename F = std::plus<>>
+OutIt parallel_inclusive_scan(InIt first, InIt last, OutIt d_first, F op = {}) {
+    using T = std::remove_cv_t<std::iter_value_t<InIt>>;
+    return blocked_scan(first, last, d_first, std::optional<T>(), op, true);
+}
+
+template <typename InIt, typename OutIt, typename F, typename T>
+OutIt parallel_inclusive_scan(InIt first, InIt last, OutIt d_first, F op, T init) {
+    return blocked_scan(first, last, d_first, std::optional<T>(std::move(init)), op, true);
+}
+
+template <typename InIt, typename OutIt, typename T, typename F = std::plus<>>
+OutIt parallel_exclusive_scan(InIt first, InIt last, OutIt d_first, T init, F op = {}) {
+    return blocked_scan(first, last, d_first, std::optional<T>(std::move(init)), op, false);
+}
+
+// chain(f, g, h)(x) == h(g(f(x))): several map stages fused into the single transform of
+// parallel_transform_reduce / parallel_map_reduce, without a pass over memory per stage
+template <typename F>
+auto chain(F f) {
+    return f;
+}
+
+template <typename F, typename... Gs>
+auto chain(F f, Gs... gs) {
+    return [f, next = chain(gs...)](auto&& x) { return next(f(std::forward<decltype(x)>(x))); };
+}
+
+// [d_first, d_first + (last - first)) = [first, last), each piece copied by the worker that
+// for_range gives it, so a fresh destination is first-touched in the same pieces as parallel_map
+template <typename Iter, typename Out>
+void parallel_copy(Iter first, Iter last, Out d_first, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(first, last));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain))
+        std::copy(first, last, d_first);
+    else
+        pool.for_range(0, size, [&](std::size_t const lo, std::size_t const hi) {
+            auto from = std::next(first, lo);
+            std::copy(from, std::next(from, hi - lo), std::next(d_first, lo));
+        }, grain);
+}
+
+// Fixed-size array for inputs too big to set up on one thread.
+//
+// The memory is page aligned and left untouched by the allocation: no zeroing like std::vector(n).
+// Linux places a page on the NUMA node of the thread that first writes it, and which worker writes
+// or later reads a piece of the pool's for_range depends on stealing, not on where the worker runs.
+// So on a host with several nodes the pages are interleaved across them with mbind() before anything
+// touches them: every constructor, numa_buffer(n) included, ends up spread evenly, and no node serves
+// all the workers alone. The constructors that take a value or a source also write in parallel.
+template <typename T>
+class numa_buffer {
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                  "numa_buffer holds plain data");
+
+    static constexpr std::size_t page_size = 4096;
+    static constexpr std::size_t per_page = std::max<std::size_t>(page_size / sizeof(T), 1);
+
+    T* ptr = nullptr;
+    std::size_t count = 0;
+
+    static T* allocate(std::size_t const n) {
+        if (n == 0) return nullptr;
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        auto p = ::operator new(n * sizeof(T), std::align_val_t{page_size});
+        interleave(p, n * sizeof(T));
+        return static_cast<T*>(p);
+    }
+
+    // round-robin over the nodes this process may use; nothing to do with one node or without NUMA support
+    static void interleave([[maybe_unused]] void* p, [[maybe_unused]] std::size_t const bytes) {
+#ifdef __linux__
+        static auto const nodes = [] {
+            std::array<unsigned long, 16> mask{};  // 1024 nodes
+            if (::syscall(SYS_get_mempolicy, nullptr, mask.data(), mask.size() * 64, nullptr, MPOL_F_MEMS_ALLOWED) != 0)
+                mask = {};
+            return mask;
+        }();
+        int count = 0;
+        for (auto const m : nodes) count += std::popcount(m);
+        if (count > 1)
+            ::syscall(SYS_mbind, p, bytes, MPOL_INTERLEAVE, nodes.data(), nodes.size() * 64, 0u);
+#endif
+    }
+
+   public:
+    numa_buffer() = default;
+
+    // default-initialized: indeterminate values, nothing touched yet
+    explicit numa_buffer(std::size_t const n) : ptr(allocate(n)), count(n) {}
+
+    numa_buffer(std::size_t const n, T const& value) : numa_buffer(n) { fill(value); }
+
+    template <std::forward_iterator Iter>
+    numa_buffer(Iter first, Iter last) : numa_buffer(static_cast<std::size_t>(std::distance(first, last))) {
+        parallel_copy(first, last, ptr, per_page);
+    }
+
+    numa_buffer(numa_buffer const& other) : numa_buffer(other.begin(), other.end()) {}
+
+    numa_buffer(numa_buffer&& other) noexcept
+        : ptr(std::exchange(other.ptr, nullptr)), count(std::exchange(other.count, 0)) {}
+
+    numa_buffer& operator=(numa_buffer other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(count, other.count);
+        return *this;
+    }
+
+    ~numa_buffer() {
+        if (ptr != nullptr) ::operator delete(ptr, std::align_val_t{page_size});
+    }
+
+    // parallel, in the pieces of for_range
+    void fill(T const& value) {
+        auto& pool = thread_pool::current();
+        if (pool.sequential(count))
+            std::fill(begin(), end(), value);
+        else
+            pool.for_range(0, count, [&](std::size_t const lo, std::size_t const hi) {
+                std::fill(ptr + lo, ptr + hi, value);
+            }, per_page);
+    }
+
+    T* data() { return ptr; }
+    T const* data() const { return ptr; }
+    std::size_t size() const { return count; }
+
+    T* begin() { return ptr; }
+    T* end() { return ptr + count; }
+    T const* begin() const { return ptr; }
+    T const* end() const { return ptr + count; }
+
+    T& operator[](std::size_t const i) { return ptr[i]; }
+    T const& operator[](std::size_t const i) const { return ptr[i]; }
+};
+
+}  // namespace ParallelUtils
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>  // std::transform
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>  // std::exception_ptr
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // std::exchange
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+
+namespace ParallelUtils {
+
+template <typename T = void>
+class task;
+
+namespace task_detail {
+    struct promise_base {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+
+        // resume whoever awaited the task, as a tail call: a long chain of finished tasks never grows the stack
+        struct final_awaiter {
+            bool await_ready() const noexcept { return false; }
+            template <typename P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) const noexcept {
+                return h.promise().continuation;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        final_awaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct promise : promise_base {
+        std::optional<T> value;  // T need not be default constructible
+
+        task<T> get_return_object();
+
+        template <typename U = T>
+        void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+        T result() {
+            if (error) std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct promise<void> : promise_base {
+        task<void> get_return_object();
+        void return_void() const noexcept {}
+
+        void result() const {
+            if (error) std::rethrow_exception(error);
+        }
+    };
+}  // namespace task_detail
+
+// A lazy coroutine: nothing runs until the task is awaited, and the awaiter continues as soon as it
+// has finished. One allocation for the frame and no shared state or locks, where every std::async
+// call allocates a shared state and may start a thread. A task runs on the thread that awaits it,
+// until it awaits schedule().
+template <typename T>
+class [[nodiscard]] task {
+   public:
+    using promise_type = task_detail::promise<T>;
+
+   private:
+    std::coroutine_handle<promise_type> handle;
+
+    template <bool take_result>
+    struct awaiter {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept { return handle.done(); }
+        // symmetric transfer: start the task in place of the caller
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) const noexcept {
+            handle.promise().continuation = caller;
+            return handle;
+        }
+        decltype(auto) await_resume() const {
+            if constexpr (take_result) return handle.promise().result();
+        }
+    };
+
+    explicit task(std::coroutine_handle<promise_type> const h) : handle(h) {}
+    friend promise_type;
+
+   public:
+    task(task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    ~task() {
+        if (handle) handle.destroy();
+    }
+
+    bool done() const { return handle.done(); }
+
+    // the result, or the exception the task threw; at most once
+    auto operator co_await() const noexcept { return awaiter<true>{handle}; }
+
+    // completion only, the result stays in the task
+    auto when_ready() const noexcept { return awaiter<false>{handle}; }
+};
+
+namespace task_detail {
+    template <typename T>
+    task<T> promise<T>::get_return_object() {
+        return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+    }
+
+    inline task<void> promise<void>::get_return_object() {
+        return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+    }
+
+    // A coroutine that is resumed by hand and reports its end to `done` in final_suspend.
+    template <typename Done>
+    struct notifier {
+        struct promise_type {
+            Done* done = nullptr;
+
+            notifier get_return_object() { return notifier{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            auto final_suspend() const noexcept {
+                struct final_awaiter {
+                    bool await_ready() const noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                        return h.promise().done->notify();
+                    }
+                    void await_resume() const noexcept {}
+                };
+                return final_awaiter{};
+            }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }  // the awaited task keeps its exception
+        };
+
+        std::coroutine_handle<promise_type> handle;
+
+        notifier(notifier&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+        explicit notifier(std::coroutine_handle<promise_type> const h) : handle(h) {}
+        ~notifier() {
+            if (handle) handle.destroy();
+        }
+
+        void start(Done& done) {
+            handle.promise().done = &done;
+            handle.resume();
+        }
+    };
+
+    template <typename T, typename Done>
+    notifier<Done> notify_when_ready(task<T> const& t) {
+        co_await t.when_ready();
+    }
+
+    // when_all: the awaiting coroutine counts as one, whoever brings the count to zero resumes it
+    struct counter {
+        std::atomic<std::size_t> count;
+        std::coroutine_handle<> waiter;
+
+        explicit counter(std::size_t const n) : count(n + 1) {}
+
+        std::coroutine_handle<> notify() noexcept {
+            return count.fetch_sub(1, std::memory_order_acq_rel) == 1 ? waiter : std::noop_coroutine();
+        }
+    };
+
+    // starts every notifier, then suspends the caller until all of them have finished
+    struct start_all {
+        std::vector<notifier<counter>>& notifiers;
+        counter& done;
+
+        bool await_ready() const noexcept { return notifiers.empty(); }
+        bool await_suspend(std::coroutine_handle<> caller) {
+            done.waiter = caller;
+            for (auto& n : notifiers) n.start(done);
+            return done.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // sync_wait: a thread outside any coroutine sleeps until the task has finished
+    struct signal {
+        std::mutex mtx;
+        std::condition_variable finished;
+        bool ready = false;  // guarded by mtx
+
+        // notified under the lock: the waiter cannot return and destroy *this before it is released
+        std::coroutine_handle<> notify() noexcept {
+            std::lock_guard lock(mtx);
+            ready = true;
+            finished.notify_one();
+            return std::noop_coroutine();
+        }
+
+        void wait() {
+            std::unique_lock lock(mtx);
+            finished.wait(lock, [&] { return ready; });
+        }
+    };
+}  // namespace task_detail
+
+// co_await schedule(pool): continue on a worker of pool. The awaiter is the pool's job, it lives in the
+// coroutine frame, so switching costs no allocation. On a worker it goes to the worker's own deque, where
+// idle workers steal it.
+class schedule_awaiter : job {
+    thread_pool& pool;
+    std::coroutine_handle<> handle;
+
+    static void execute(job* j) { static_cast<schedule_awaiter*>(j)->handle.resume(); }
+
+   public:
+    explicit schedule_awaiter(thread_pool& pool) : job{&schedule_awaiter::execute}, pool(pool) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        pool.post(this);  // another worker may resume h before post returns, *this is not touched after it
+    }
+    void await_resume() const noexcept {}
+};
+
+inline schedule_awaiter schedule(thread_pool& pool = thread_pool::current()) {
+    return schedule_awaiter(pool);
+}
+
+// all results in order, after every task has finished; the first exception in order is rethrown
+template <typename T>
+task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> when_all(std::vector<task<T>> tasks) {
+    std::vector<task_detail::notifier<task_detail::counter>> notifiers;
+    notifiers.reserve(tasks.size());
+    for (auto const& t : tasks) notifiers.push_back(task_detail::notify_when_ready<T, task_detail::counter>(t));
+    task_detail::counter done(tasks.size());
+    co_await task_detail::start_all{notifiers, done};
+
+    if constexpr (std::is_void_v<T>) {
+        for (auto& t : tasks) co_await t;
+    } else {
+        std::vector<T> results;
+        results.reserve(tasks.size());
+        for (auto& t : tasks) results.push_back(co_await t);
+        co_return results;
+    }
+}
+
+template <typename... Ts>
+    requires(!std::is_void_v<Ts> && ...)
+task<std::tuple<Ts...>> when_all(task<Ts>... tasks) {
+    std::vector<task_detail::notifier<task_detail::counter>> notifiers;
+    notifiers.reserve(sizeof...(Ts));
+    (notifiers.push_back(task_detail::notify_when_ready<Ts, task_detail::counter>(tasks)), ...);
+    task_detail::counter done(sizeof...(Ts));
+    co_await task_detail::start_all{notifiers, done};
+    co_return std::tuple<Ts...>{co_await tasks...};
+}
+
+// run t from a thread that is not a coroutine and wait for its result
+template <typename T>
+T sync_wait(task<T> const& t) {
+    task_detail::signal done;
+    auto waiter = task_detail::notify_when_ready<T, task_detail::signal>(t);
+    waiter.start(done);
+    done.wait();
+    return t.operator co_await().await_resume();  // finished, so this only takes the result
+}
+
+// co_parallel_map/co_parallel_reduce: about four blocks per worker, each a task that moves itself to the
+// pool, awaited together with when_all. Composes with other tasks without blocking a thread.
+namespace task_detail {
+    template <typename Iter, typename F>
+    task<> map_block(thread_pool& pool, Iter first, Iter last, F const& f) {
+        co_await schedule(pool);
+        std::transform(first, last, first, f);
+    }
+
+    // [first, last) is never empty: the block starts from its first element, not from R{},
+    // which need not be the identity of op; the caller folds init in once
+    template <typename Iter, typename R, typename F>
+    task<R> reduce_block(thread_pool& pool, Iter first, Iter last, F const& op) {
+        co_await schedule(pool);
+        co_return simd::reduce(std::next(first), last, R(*first), op);
+    }
+
+    inline std::size_t block_size(thread_pool& pool, std::size_t const size, std::size_t const grain) {
+        auto block = (size + pool.size() * 4 - 1) / (pool.size() * 4);
+        return std::max({block, grain, std::size_t{1}});
+    }
+}  // namespace task_detail
+
+template <typename Iter, typename F>
+task<> co_parallel_map(Iter begin, Iter end, F f, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain)) {
+        std::transform(begin, end, begin, f);
+        co_return;
+    }
+
+    auto block = task_detail::block_size(pool, size, grain);
+    std::vector<task<>> blocks;
+    for (std::size_t lo = 0; lo < size; lo += block) {
+        auto first = std::next(begin, lo);
+        blocks.push_back(task_detail::map_block(pool, first, std::next(first, std::min(block, size - lo)), f));
+    }
+    co_await when_all(std::move(blocks));
+}
+
+template <typename Iter, typename R, typename F>
+task<R> co_parallel_reduce(Iter begin, Iter end, R init, F op, std::size_t const grain = 0) {
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto& pool = thread_pool::current();
+
+    if (pool.sequential(size, grain)) co_return simd::reduce(begin, end, init, op);
+
+    auto block = task_detail::block_size(pool, size, grain);
+    std::vector<task<R>> blocks;
+    for (std::size_t lo = 0; lo < size; lo += block) {
+        auto first = std::next(begin, lo);
+        blocks.push_back(task_detail::reduce_block<Iter, R>(pool, first, std::next(first, std::min(block, size - lo)), op));
+    }
+    for (auto& value : co_await when_all(std::move(blocks))) init = op(std::move(init), std::move(value));
+    co_return init;
+}
+
+}  // namespace ParallelUtils
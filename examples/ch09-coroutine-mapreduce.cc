@@ -0,0 +1,77 @@
+#include <algorithm>  // std::transform
+#include <chrono>
+#include <functional>  // std::plus, std::multiplies
+#include <future>
+#include <iostream>
+#include <numeric>  // std::reduce
+#include <thread>
+#include <vector>
+
+#include "ch09-Task.h"
+#include "PerfTimer.h"
+
+// as in ch09-async-mapreduce.cc: one std::async per part
+long long async_map_reduce(std::vector<unsigned char>& v, unsigned const parts) {
+    auto part = v.size() / parts;
+    std::vector<std::future<long long>> tasks;
+    for (unsigned i = 0; i < parts; ++i) {
+        auto first = v.begin() + i * part;
+        auto last = i == parts - 1 ? v.end() : first + part;
+        tasks.push_back(std::async(std::launch::async, [=] {
+            std::transform(first, last, first, [](unsigned char const c) -> unsigned char { return c ^ 1; });
+            return std::reduce(first, last, 0LL);
+        }));
+    }
+    long long sum = 0;
+    for (auto& t : tasks) sum += t.get();
+    return sum;
+}
+
+ParallelUtils::task<long long> co_map_reduce(std::vector<unsigned char>& v) {
+    co_await ParallelUtils::co_parallel_map(v.begin(), v.end(), [](unsigned char const c) -> unsigned char { return c ^ 1; });
+    co_return co_await ParallelUtils::co_parallel_reduce(v.begin(), v.end(), 0LL, std::plus<>());
+}
+
+// two independent stages at once, each a parallel reduce of its own
+ParallelUtils::task<double> vwap(std::vector<double> const& notional, std::vector<double> const& volume) {
+    auto [n, v] = co_await ParallelUtils::when_all(
+        ParallelUtils::co_parallel_reduce(notional.begin(), notional.end(), 0.0, std::plus<>()),
+        ParallelUtils::co_parallel_reduce(volume.begin(), volume.end(), 0.0, std::plus<>()));
+    co_return n / v;
+}
+
+int main() {
+    auto const parts = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // example1: many small stages, where the cost of starting the parts shows
+    {
+        std::size_t const stages = 10'000;
+        std::vector<unsigned char> v(1e5, 1);
+        long long s1 = 0, s2 = 0;
+        auto t1 = perf_timer<>::duration([&] {
+            for (std::size_t i = 0; i < stages; ++i) s1 += async_map_reduce(v, parts);
+        });
+        auto t2 = perf_timer<>::duration([&] {
+            for (std::size_t i = 0; i < stages; ++i) s2 += ParallelUtils::sync_wait(co_map_reduce(v));
+        });
+        std::cout << "   std::async sum: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "co_parallel_* sum: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+    // example2: one large stage, the parts are long enough that both approaches run at memory speed
+    // (each run flips every element, so the two sums alternate between 0 and the size)
+    {
+        std::vector<unsigned char> v(1e9, 1);
+        long long s1 = 0, s2 = 0;
+        auto t1 = perf_timer<>::duration([&] { s1 = async_map_reduce(v, parts); });
+        auto t2 = perf_timer<>::duration([&] { s2 = ParallelUtils::sync_wait(co_map_reduce(v)); });
+        std::cout << "   std::async sum: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "co_parallel_* sum: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+    // example3: when_all over two independent stages
+    {
+        std::vector<double> price(1e7, 101.5), volume(1e7, 200.0);
+        std::vector<double> notional(price.size());
+        std::transform(price.begin(), price.end(), volume.begin(), notional.begin(), std::multiplies<>());
+        std::cout << "vwap: " << ParallelUtils::sync_wait(vwap(notional, volume)) << '\n';
+    }
+}
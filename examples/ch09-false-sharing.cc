@@ -0,0 +1,50 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+// Every thread sums its part straight into its slot, one update per element. The loads through
+// unsigned char may alias the slot, so the compiler keeps the running sum in memory, not a register.
+template <typename Slots>
+long long reduce_into(std::vector<unsigned char> const& v, Slots& values, unsigned const threads) {
+    auto part = v.size() / threads;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        auto first = v.begin() + i * part;
+        auto last = i == threads - 1 ? v.end() : first + part;
+        workers.emplace_back([=, &values] {
+            for (auto it = first; it != last; ++it) values[i] += *it;
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    long long sum = 0;
+    for (unsigned i = 0; i < threads; ++i) sum += values[i];
+    return sum;
+}
+
+int main() {
+    std::size_t const size = 4e8;
+    std::vector<unsigned char> v(size, 1);
+    auto const threads = std::max(ParallelUtils::available_cpus(), 2u);
+
+    // example1: long long slots side by side, eight of them on one cache line
+    {
+        std::vector<long long> values(threads);
+        long long sum = 0;
+        auto t = perf_timer<>::duration([&] { sum = reduce_into(v, values, threads); });
+        std::cout << "   std::vector<long long> sum: " << sum << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example2: each slot on its own cache line
+    {
+        ParallelUtils::per_worker<long long> values(threads);
+        long long sum = 0;
+        auto t = perf_timer<>::duration([&] { sum = reduce_into(v, values, threads); });
+        std::cout << "per_worker<long long> sum: " << sum << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    std::cout << "threads: " << threads << ", cache line: " << ParallelUtils::cache_line
+              << ", sizeof(padded<long long>): " << sizeof(ParallelUtils::padded<long long>) << '\n';
+}
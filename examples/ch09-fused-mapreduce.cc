@@ -0,0 +1,54 @@
+#include <chrono>
+#include <functional>  // std::plus
+#include <iostream>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+int main() {
+    std::vector<unsigned char> v(5e8, 1);
+    auto flip = [](unsigned char const i) -> unsigned char { return i ^ 3; };
+
+    // example1: one map, then reduce
+    {
+        auto v1 = v, v2 = v;
+        auto s1 = 0LL, s2 = 0LL, s3 = 0LL;
+
+        auto t1 = perf_timer<>::duration([&] {
+            ParallelUtils::parallel_map(std::begin(v1), std::end(v1), flip);
+            s1 = ParallelUtils::parallel_reduce(std::begin(v1), std::end(v1), 0LL, std::plus<>());
+        });
+        // v2 ends up mapped like v1
+        auto t2 = perf_timer<>::duration([&] {
+            s2 = ParallelUtils::parallel_map_reduce(std::begin(v2), std::end(v2), flip, 0LL, std::plus<>());
+        });
+        // v is only read
+        auto t3 = perf_timer<>::duration([&] {
+            s3 = ParallelUtils::parallel_transform_reduce(std::begin(v), std::end(v), 0LL, std::plus<>(), flip);
+        });
+        std::cout << "      map, reduce sum:" << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "       map_reduce sum:" << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+        std::cout << " transform_reduce sum:" << s3 << ", cost: " << std::chrono::duration<double, std::milli>(t3) << '\n';
+    }
+    // example2: three map stages, then reduce
+    {
+        auto v3 = v;
+        auto twice = [](unsigned char const i) -> unsigned char { return i * 2; };
+        auto plus3 = [](unsigned char const i) -> unsigned char { return i + 3; };
+        auto s1 = 0LL, s2 = 0LL;
+
+        auto t1 = perf_timer<>::duration([&] {
+            ParallelUtils::parallel_map(std::begin(v3), std::end(v3), flip);
+            ParallelUtils::parallel_map(std::begin(v3), std::end(v3), twice);
+            ParallelUtils::parallel_map(std::begin(v3), std::end(v3), plus3);
+            s1 = ParallelUtils::parallel_reduce(std::begin(v3), std::end(v3), 0LL, std::plus<>());
+        });
+        auto t2 = perf_timer<>::duration([&] {
+            s2 = ParallelUtils::parallel_transform_reduce(std::begin(v), std::end(v), 0LL, std::plus<>(),
+                                                          ParallelUtils::chain(flip, twice, plus3));
+        });
+        std::cout << "3 maps, reduce sum:" << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "       chained sum:" << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+}
@@ -0,0 +1,249 @@
+// Every map/reduce variant of this chapter in one program, swept over sizes and thread counts.
+//
+//   ./a.out [--sizes 1e6,1e8] [--threads 1,2,4] [--warmup 1] [--reps 5] [--impl pool,pool_map_reduce] [--format csv|json]
+//
+// std::execution::par needs -ltbb with libstdc++, see "with STL standard algorithms".
+#include <algorithm>  // std::transform
+#include <chrono>
+#include <execution>  // std::execution::par
+#include <functional>  // std::plus
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>  // std::unique_ptr
+#include <numeric>  // std::reduce
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+using data = std::vector<unsigned char>;
+
+auto const map_op = [](unsigned char const i) -> unsigned char { return i ^ 1; };
+
+// example2 and example3 with the thread count as a parameter
+namespace spawn {
+template <typename Launch>
+void map(data& v, unsigned const threads, Launch launch) {
+    auto part = v.size() / threads;
+    std::vector<decltype(launch([] {}))> handles;
+    for (unsigned i = 0; i < threads; ++i) {
+        auto first = v.begin() + i * part;
+        auto last = i == threads - 1 ? v.end() : first + part;
+        handles.push_back(launch([=] { std::transform(first, last, first, map_op); }));
+    }
+    for (auto& h : handles) h.join();
+}
+
+template <typename Launch>
+long long reduce(data const& v, unsigned const threads, Launch launch) {
+    auto part = v.size() / threads;
+    ParallelUtils::per_worker<long long> values(threads);
+    std::vector<decltype(launch([] {}))> handles;
+    for (unsigned i = 0; i < threads; ++i) {
+        auto first = v.begin() + i * part;
+        auto last = i == threads - 1 ? v.end() : first + part;
+        handles.push_back(launch([=, &values] { values[i] = std::reduce(first, last, 0LL, std::plus<>()); }));
+    }
+    for (auto& h : handles) h.join();
+    return values.combine(0LL, std::plus<>());
+}
+
+auto const thread = [](auto f) { return std::thread(std::move(f)); };
+
+// std::future has wait(), not join()
+struct joinable_future {
+    std::future<void> f;
+    void join() { f.wait(); }
+};
+auto const async = [](auto f) { return joinable_future{std::async(std::launch::async, std::move(f))}; };
+}  // namespace spawn
+
+// one implementation: map in place then reduce, returns the sum
+struct implementation {
+    std::string_view name;
+    bool scales;  // false: the library picks the thread count, run once per size
+    long long (*run)(data&, unsigned threads);
+};
+
+template <typename Policy>
+long long with_policy(Policy&& policy, data& v) {
+    std::transform(policy, v.begin(), v.end(), v.begin(), map_op);
+    return std::reduce(policy, v.begin(), v.end(), 0LL, std::plus<>());
+}
+
+// ParallelUtils on a pool of the requested size, see thread_pool::current()
+template <typename F>
+long long on_pool(unsigned const threads, F f) {
+    static std::map<unsigned, std::unique_ptr<ParallelUtils::thread_pool>> pools;
+    auto& pool = pools[threads];
+    if (!pool) pool = std::make_unique<ParallelUtils::thread_pool>(threads);
+    long long sum = 0;
+    pool->in_pool([&] { sum = f(); });
+    return sum;
+}
+
+implementation const implementations[] = {
+    {"std_default", false, [](data& v, unsigned) {
+         std::transform(v.begin(), v.end(), v.begin(), map_op);
+         return std::reduce(v.begin(), v.end(), 0LL, std::plus<>());
+     }},
+    {"std_seq", false, [](data& v, unsigned) { return with_policy(std::execution::seq, v); }},
+    {"std_par", false, [](data& v, unsigned) { return with_policy(std::execution::par, v); }},
+    {"std_unseq", false, [](data& v, unsigned) { return with_policy(std::execution::unseq, v); }},
+    {"std_par_unseq", false, [](data& v, unsigned) { return with_policy(std::execution::par_unseq, v); }},
+    {"std_transform_reduce_par", false, [](data& v, unsigned) {
+         return std::transform_reduce(std::execution::par, v.begin(), v.end(), 0LL, std::plus<>(), map_op);
+     }},
+    {"thread", true, [](data& v, unsigned threads) {
+         spawn::map(v, threads, spawn::thread);
+         return spawn::reduce(v, threads, spawn::thread);
+     }},
+    {"async", true, [](data& v, unsigned threads) {
+         spawn::map(v, threads, spawn::async);
+         return spawn::reduce(v, threads, spawn::async);
+     }},
+    {"pool", true, [](data& v, unsigned threads) {
+         return on_pool(threads, [&] {
+             ParallelUtils::parallel_map(v.begin(), v.end(), map_op);
+             return ParallelUtils::parallel_reduce(v.begin(), v.end(), 0LL, std::plus<>());
+         });
+     }},
+    {"pool_map_reduce", true, [](data& v, unsigned threads) {
+         return on_pool(threads, [&] {
+             return ParallelUtils::parallel_map_reduce(v.begin(), v.end(), map_op, 0LL, std::plus<>());
+         });
+     }},
+    {"pool_transform_reduce", true, [](data& v, unsigned threads) {
+         return on_pool(threads, [&] {
+             return ParallelUtils::parallel_transform_reduce(v.begin(), v.end(), 0LL, std::plus<>(), map_op);
+         });
+     }},
+};
+
+struct options {
+    std::vector<std::size_t> sizes = {1'000'000, 100'000'000};
+    std::vector<unsigned> threads;
+    int warmup = 1;
+    int reps = 5;
+    std::vector<std::string> impls;  // empty: all
+    std::string format = "csv";
+};
+
+template <typename T>
+std::vector<T> parse_list(std::string const& s) {
+    std::vector<T> out;
+    std::stringstream in(s);
+    for (std::string item; std::getline(in, item, ',');) {
+        if constexpr (std::is_same_v<T, std::string>)
+            out.push_back(item);
+        else
+            out.push_back(static_cast<T>(std::stod(item)));  // accepts 1e9
+    }
+    return out;
+}
+
+options parse(int argc, char const* argv[]) {
+    options opt;
+    for (int i = 1; i < argc; i += 2) {
+        std::string_view key = argv[i];
+        if (i + 1 == argc) throw std::invalid_argument("missing value for " + std::string(key));
+        std::string value = argv[i + 1];
+        if (key == "--sizes") opt.sizes = parse_list<std::size_t>(value);
+        else if (key == "--threads") opt.threads = parse_list<unsigned>(value);
+        else if (key == "--warmup") opt.warmup = std::stoi(value);
+        else if (key == "--reps") opt.reps = std::max(std::stoi(value), 1);
+        else if (key == "--impl") opt.impls = parse_list<std::string>(value);
+        else if (key == "--format") opt.format = value;
+        else throw std::invalid_argument("unknown option " + std::string(key));
+    }
+    std::erase(opt.threads, 0u);
+    if (opt.threads.empty()) {
+        // 1, 2, 4, ... and the CPUs this process may use
+        auto cpus = ParallelUtils::available_cpus();
+        for (unsigned t = 1; t < cpus; t *= 2) opt.threads.push_back(t);
+        opt.threads.push_back(cpus);
+    }
+    return opt;
+}
+
+struct result {
+    std::string_view impl;
+    bool scales;
+    std::size_t size;
+    unsigned threads;  // 0: chosen by the library
+    double best_ms;
+    double median_ms;
+    double gbps;  // input bytes per second at the median
+    double speedup;
+    bool correct;
+};
+
+int main(int argc, char const* argv[]) {
+    auto opt = parse(argc, argv);
+    std::vector<result> results;
+
+    for (auto size : opt.sizes) {
+        data v(size, 1);
+        unsigned char value = 1;  // every element, map_op flips it on each run
+
+        for (auto const& impl : implementations) {
+            if (!opt.impls.empty() && std::find(opt.impls.begin(), opt.impls.end(), impl.name) == opt.impls.end())
+                continue;
+
+            auto thread_counts = impl.scales ? opt.threads : std::vector<unsigned>{0};
+            for (auto threads : thread_counts) {
+                // map_reduce and the std::transform(...) ones write back, transform_reduce only reads
+                bool const writes = impl.name != "pool_transform_reduce" && impl.name != "std_transform_reduce_par";
+                bool correct = true;
+                std::vector<double> times;
+                for (int r = 0; r < opt.warmup + opt.reps; ++r) {
+                    long long sum = 0;
+                    auto t = perf_timer<>::duration([&] { sum = impl.run(v, std::max(threads, 1u)); });
+                    correct &= sum == static_cast<long long>(size) * map_op(value);
+                    if (writes) value = map_op(value);
+                    if (r >= opt.warmup) times.push_back(std::chrono::duration<double, std::milli>(t).count());
+                }
+                std::sort(times.begin(), times.end());
+                auto median = times[times.size() / 2];
+                results.push_back({impl.name, impl.scales, size, threads, times.front(), median,
+                                   static_cast<double>(size) / (median * 1e6), 1.0, correct});
+            }
+        }
+    }
+
+    // speedup: vs the fewest threads of the same implementation, vs std_seq when the library picks;
+    // --threads may list the counts in any order
+    for (auto& r : results) {
+        auto base = results.end();
+        for (auto b = results.begin(); b != results.end(); ++b) {
+            if (b->size != r.size || (r.scales ? b->impl != r.impl : b->impl != "std_seq")) continue;
+            if (base == results.end() || b->threads < base->threads) base = b;
+        }
+        if (base != results.end()) r.speedup = base->median_ms / r.median_ms;
+    }
+
+    std::cout.precision(6);
+    if (opt.format == "json") {
+        std::cout << "[\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            auto const& r = results[i];
+            std::cout << "  {\"impl\": \"" << r.impl << "\", \"size\": " << r.size << ", \"threads\": " << r.threads
+                      << ", \"best_ms\": " << r.best_ms << ", \"median_ms\": " << r.median_ms
+                      << ", \"gbps\": " << r.gbps << ", \"speedup\": " << r.speedup
+                      << ", \"correct\": " << (r.correct ? "true" : "false") << '}'
+                      << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "impl,size,threads,best_ms,median_ms,gbps,speedup,correct\n";
+        for (auto const& r : results)
+            std::cout << r.impl << ',' << r.size << ',' << r.threads << ',' << r.best_ms << ',' << r.median_ms
+                      << ',' << r.gbps << ',' << r.speedup << ',' << r.correct << '\n';
+    }
+}
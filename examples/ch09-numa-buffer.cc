@@ -0,0 +1,54 @@
+#include <chrono>
+#include <functional>  // std::plus
+#include <iostream>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+int main() {
+    std::size_t const size = 1e9;
+    auto flip = [](unsigned char const i) -> unsigned char { return i ^ 1; };
+
+    // example1: set-up on one thread, as in the other examples
+    {
+        std::vector<unsigned char> v;
+        std::vector<unsigned char> v0;
+        auto s0 = 0LL;
+
+        auto t1 = perf_timer<>::duration([&] { v.assign(size, 1); });
+        auto t2 = perf_timer<>::duration([&] { v0 = v; });
+        auto t3 = perf_timer<>::duration([&] {
+            ParallelUtils::parallel_map(std::begin(v0), std::end(v0), flip);
+            s0 = ParallelUtils::parallel_reduce(std::begin(v0), std::end(v0), 0LL, std::plus<>());
+        });
+        std::cout << "     vector sum:" << s0
+                  << ", fill cost: " << std::chrono::duration<double, std::milli>(t1)
+                  << ", copy cost: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", map+reduce cost: " << std::chrono::duration<double, std::milli>(t3) << '\n';
+    }
+    // example2: filled and copied in parallel, each page first touched by a worker
+    {
+        ParallelUtils::numa_buffer<unsigned char> v;
+        ParallelUtils::numa_buffer<unsigned char> v0;
+        auto s0 = 0LL;
+
+        auto t1 = perf_timer<>::duration([&] { v = ParallelUtils::numa_buffer<unsigned char>(size, 1); });
+        auto t2 = perf_timer<>::duration([&] { v0 = v; });
+        auto t3 = perf_timer<>::duration([&] {
+            ParallelUtils::parallel_map(std::begin(v0), std::end(v0), flip);
+            s0 = ParallelUtils::parallel_reduce(std::begin(v0), std::end(v0), 0LL, std::plus<>());
+        });
+        std::cout << "numa_buffer sum:" << s0
+                  << ", fill cost: " << std::chrono::duration<double, std::milli>(t1)
+                  << ", copy cost: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", map+reduce cost: " << std::chrono::duration<double, std::milli>(t3) << '\n';
+    }
+    // example3: no zeroing, the allocation itself costs nothing until the pages are written
+    {
+        auto t1 = perf_timer<>::duration([&] { std::vector<unsigned char> v(size); });
+        auto t2 = perf_timer<>::duration([&] { ParallelUtils::numa_buffer<unsigned char> v(size); });
+        std::cout << "     vector(n) cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "numa_buffer(n) cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    }
+}
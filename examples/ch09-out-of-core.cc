@@ -0,0 +1,68 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>  // std::plus
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "ch09-OutOfCore.h"
+#include "PerfTimer.h"
+
+int main() {
+    // raise files * file_size above the RAM of the machine to see the difference; the first
+    // run after writing mostly reads the page cache, drop it to measure the disk
+    //   sync; echo 1 | sudo tee /proc/sys/vm/drop_caches
+    std::size_t const files = 4;
+    std::size_t const file_size = 5e8;
+
+    std::vector<std::string> paths;
+    {
+        std::vector<unsigned char> v(file_size, 1);
+        for (std::size_t i = 0; i < files; ++i) {
+            auto path = std::filesystem::temp_directory_path() / ("ch09-out-of-core-" + std::to_string(i) + ".bin");
+            std::ofstream(path, std::ios::binary).write(reinterpret_cast<char const*>(v.data()), v.size());
+            paths.push_back(path.string());
+        }
+    }
+    auto flip = [](unsigned char const i) -> long long { return i ^ 3; };
+
+    // example1: read every file into memory first, as parallel_map/parallel_reduce need
+    {
+        auto s0 = 0LL;
+        auto t = perf_timer<>::duration([&] {
+            for (auto const& path : paths) {
+                std::vector<unsigned char> v(std::filesystem::file_size(path));
+                std::ifstream in(path, std::ios::binary);
+                in.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(v.size()));
+                v.resize(static_cast<std::size_t>(in.gcount()));
+                s0 += ParallelUtils::parallel_transform_reduce(std::begin(v), std::end(v), 0LL, std::plus<>(), flip);
+            }
+        });
+        std::cout << "read + parallel_transform_reduce sum: " << s0
+                  << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example2: map two windows at a time, the next one read ahead while the current one is reduced
+    {
+        auto s0 = 0LL;
+        auto t = perf_timer<>::duration([&] {
+            s0 = ParallelUtils::out_of_core_transform_reduce<unsigned char>(paths, 0LL, std::plus<>(), flip);
+        });
+        std::cout << "     out_of_core_transform_reduce sum: " << s0
+                  << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example3: partial results as they come, one per window
+    {
+        ParallelUtils::out_of_core_options options;
+        options.window = 128 << 20;
+        ParallelUtils::out_of_core_transform_reduce<unsigned char>(
+            paths, 0LL, std::plus<>(), flip,
+            [](std::string const& path, std::size_t const first, long long const partial) {
+                std::cout << path << " from " << first << ": " << partial << '\n';
+            },
+            options);
+    }
+
+    for (auto const& path : paths) std::filesystem::remove(path);
+}
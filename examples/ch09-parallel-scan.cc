@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>  // std::inclusive_scan
+#include <random>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+int main() {
+    std::size_t const ticks = 5e7;
+    std::vector<double> price(ticks);
+    std::vector<std::int64_t> volume(ticks);
+    {
+        std::mt19937_64 gen(42);
+        std::uniform_int_distribution<std::int64_t> lots(1, 100);
+        std::normal_distribution<double> step(0.0, 0.01);
+        double p = 100.0;
+        for (std::size_t i = 0; i < ticks; ++i) {
+            p += step(gen);
+            price[i] = p;
+            volume[i] = lots(gen) * 100;
+        }
+    }
+
+    // example1: cumulative volume
+    {
+        std::vector<std::int64_t> cum1(ticks), cum2(ticks);
+        auto t1 = perf_timer<>::duration([&] { std::inclusive_scan(std::begin(volume), std::end(volume), std::begin(cum1)); });
+        auto t2 = perf_timer<>::duration([&] { ParallelUtils::parallel_inclusive_scan(std::begin(volume), std::end(volume), std::begin(cum2)); });
+        std::cout << "     std::inclusive_scan cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "parallel_inclusive_scan cost: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", same result: " << (cum1 == cum2) << '\n';
+    }
+    // example2: VWAP series, sum(price * volume) / sum(volume) up to each tick
+    {
+        std::vector<double> notional(ticks), cum_volume(ticks), vwap(ticks);
+        auto& pool = ParallelUtils::thread_pool::current();
+        auto t = perf_timer<>::duration([&] {
+            pool.for_range(0, ticks, [&](std::size_t const lo, std::size_t const hi) {
+                for (auto i = lo; i < hi; ++i) {
+                    notional[i] = price[i] * static_cast<double>(volume[i]);
+                    cum_volume[i] = static_cast<double>(volume[i]);
+                }
+            });
+            ParallelUtils::parallel_inclusive_scan(std::begin(notional), std::end(notional), std::begin(notional));
+            ParallelUtils::parallel_inclusive_scan(std::begin(cum_volume), std::end(cum_volume), std::begin(cum_volume));
+            pool.for_range(0, ticks, [&](std::size_t const lo, std::size_t const hi) {
+                for (auto i = lo; i < hi; ++i) vwap[i] = notional[i] / cum_volume[i];
+            });
+        });
+        std::cout << "vwap at the last tick: " << vwap.back() << ", price: " << price.back()
+                  << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example3: exclusive scan, the offset of every record in a packed buffer
+    {
+        std::vector<std::uint32_t> lengths = {3, 5, 2, 7};
+        std::vector<std::uint32_t> offsets(lengths.size());
+        ParallelUtils::parallel_exclusive_scan(std::begin(lengths), std::end(lengths), std::begin(offsets), 0u);
+        for (auto o : offsets) std::cout << o << ' ';  // 0 3 8 10
+        std::cout << '\n';
+    }
+}
@@ -0,0 +1,73 @@
+#include <algorithm>  // std::sort
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ch09-ParallelSort.h"
+#include "PerfTimer.h"
+
+struct tick {
+    std::int64_t timestamp;  // ns since epoch
+    std::array<char, 8> symbol;
+    double price;
+    std::uint32_t volume;
+};
+
+int main() {
+    std::size_t const size = 2e7;
+    std::vector<tick> ticks(size);
+    {
+        std::mt19937_64 gen(7);
+        std::int64_t const start = 1'700'000'000'000'000'000;
+        std::uniform_int_distribution<std::int64_t> ns(0, 86'400'000'000'000);
+        std::uniform_int_distribution<int> letter('A', 'Z');
+        for (auto& t : ticks) {
+            t.timestamp = start + ns(gen);
+            t.symbol = {char(letter(gen)), char(letter(gen)), char(letter(gen)), ' ', ' ', ' ', ' ', ' '};
+            t.price = 100.0 + static_cast<double>(gen() % 10000) / 100.0;
+            t.volume = static_cast<std::uint32_t>(gen() % 1000);
+        }
+    }
+    auto by_time = [](tick const& a, tick const& b) { return a.timestamp < b.timestamp; };
+
+    // example1: records by timestamp
+    {
+        auto v1 = ticks, v2 = ticks, v3 = ticks;
+        auto t1 = perf_timer<>::duration([&] { std::sort(std::begin(v1), std::end(v1), by_time); });
+        auto t2 = perf_timer<>::duration([&] { ParallelUtils::parallel_sort(std::begin(v2), std::end(v2), by_time); });
+        auto t3 = perf_timer<>::duration([&] {
+            ParallelUtils::parallel_radix_sort(std::begin(v3), std::end(v3), [](tick const& t) { return t.timestamp; });
+        });
+        std::cout << "          std::sort cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "parallel sample sort cost: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", sorted: " << std::is_sorted(std::begin(v2), std::end(v2), by_time) << '\n';
+        std::cout << "parallel radix sort cost: " << std::chrono::duration<double, std::milli>(t3)
+                  << ", sorted: " << std::is_sorted(std::begin(v3), std::end(v3), by_time) << '\n';
+    }
+    // example2: radix sort is stable, so sorting by time and then by symbol groups each symbol in time order
+    {
+        auto v = ticks;
+        ParallelUtils::parallel_radix_sort(std::begin(v), std::end(v), [](tick const& t) { return t.timestamp; });
+        ParallelUtils::parallel_radix_sort(std::begin(v), std::end(v), [](tick const& t) { return t.symbol; });
+        auto in_order = std::is_sorted(std::begin(v), std::end(v), [](tick const& a, tick const& b) {
+            return a.symbol != b.symbol ? a.symbol < b.symbol : a.timestamp < b.timestamp;
+        });
+        std::cout << "by symbol, then time: " << in_order << '\n';
+    }
+    // example3: plain keys, negative doubles included
+    {
+        std::vector<double> prices(size);
+        std::mt19937_64 gen(11);
+        std::normal_distribution<double> change(0.0, 1.0);
+        for (auto& p : prices) p = change(gen);
+        auto v1 = prices, v2 = prices;
+        auto t1 = perf_timer<>::duration([&] { std::sort(std::begin(v1), std::end(v1)); });
+        auto t2 = perf_timer<>::duration([&] { ParallelUtils::parallel_radix_sort(std::begin(v2), std::end(v2)); });
+        std::cout << "     double std::sort cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "double radix sort cost: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", same result: " << (v1 == v2) << '\n';
+    }
+}
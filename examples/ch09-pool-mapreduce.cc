@@ -0,0 +1,132 @@
+#include <algorithm>  // std::transform
+#include <chrono>
+#include <functional>  // std::plus, std::ref
+#include <iostream>
+#include <numeric>  // std::reduce
+#include <thread>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+// the std::thread version of example2: new threads on every call
+template <typename Iter, typename F>
+void spawn_parallel_map(Iter begin, Iter end, F f) {
+    auto size = std::distance(begin, end);
+
+    if (size < 1e4)
+        std::transform(begin, end, begin, std::forward<F>(f));
+    else {
+        auto core_nums = ParallelUtils::available_cpus();
+        auto part = size / core_nums;
+        auto last = begin;
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < core_nums; ++i) {
+            if (i == core_nums - 1)
+                last = end;
+            else
+                std::advance(last, part);
+
+            threads.emplace_back([=, &f] { std::transform(begin, last, begin, f); });
+
+            begin = last;
+        }
+
+        for (auto& t : threads) t.join();
+    }
+}
+
+template <typename Iter, typename R, typename F>
+auto spawn_parallel_reduce(Iter begin, Iter end, R init, F op) {
+    auto size = std::distance(begin, end);
+
+    if (size < 1e4)
+        return std::reduce(begin, end, init, std::forward<F>(op));
+    else {
+        auto core_nums = ParallelUtils::available_cpus();
+        auto part = size / core_nums;
+        auto last = begin;
+
+        std::vector<std::thread> threads;
+        ParallelUtils::per_worker<R> values(core_nums);  // one cache line per thread
+        for (unsigned i = 0; i < core_nums; ++i) {
+            if (i == core_nums - 1)
+                last = end;
+            else
+                std::advance(last, part);
+
+            threads.emplace_back([=, &op](R& result) { result = std::reduce(begin, last, R{}, op); }, std::ref(values[i]));
+
+            begin = last;
+        }
+
+        for (auto& t : threads) t.join();
+
+        return values.combine(init, op);
+    }
+}
+
+int main() {
+    std::cout << "hardware_concurrency: " << std::thread::hardware_concurrency()
+              << ", available_cpus: " << ParallelUtils::available_cpus() << '\n';
+
+    // many calls on a medium-sized vector, where starting threads per call dominates
+    std::vector<unsigned char> v(1e6, 1);
+    constexpr int calls = 1000;
+
+    {
+        auto v0 = v;
+        auto s0 = 0LL;
+
+        auto t01 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                std::transform(std::begin(v0), std::end(v0), std::begin(v0),
+                               [](unsigned char const i) { return i ^ 1; });
+        });
+        auto t02 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                s0 = std::reduce(std::begin(v0), std::end(v0), 0LL, std::plus<>());
+        });
+        std::cout << "   default sum:" << s0
+                  << ", map cost: " << std::chrono::duration<double, std::milli>(t01)
+                  << ", reduce cost: " << std::chrono::duration<double, std::milli>(t02)
+                  << ", map+reduce cost: " << std::chrono::duration<double, std::milli>(t01 + t02) << '\n';
+    }
+    {
+        auto v1 = v;
+        auto s1 = 0LL;
+
+        auto t11 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                spawn_parallel_map(std::begin(v1), std::end(v1),
+                                   [](unsigned char const i) { return i ^ 1; });
+        });
+        auto t12 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                s1 = spawn_parallel_reduce(std::begin(v1), std::end(v1), 0LL, std::plus<>());
+        });
+        std::cout << "     spawn sum:" << s1
+                  << ", map cost: " << std::chrono::duration<double, std::milli>(t11)
+                  << ", reduce cost: " << std::chrono::duration<double, std::milli>(t12)
+                  << ", map+reduce cost: " << std::chrono::duration<double, std::milli>(t11 + t12) << '\n';
+    }
+    {
+        auto v2 = v;
+        auto s2 = 0LL;
+
+        auto t21 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                ParallelUtils::parallel_map(std::begin(v2), std::end(v2),
+                                            [](unsigned char const i) { return i ^ 1; });
+        });
+        auto t22 = perf_timer<>::duration([&] {
+            for (int i = 0; i < calls; ++i)
+                s2 = ParallelUtils::parallel_reduce(std::begin(v2), std::end(v2), 0LL, std::plus<>());
+        });
+        std::cout << "      pool sum:" << s2
+                  << ", map cost: " << std::chrono::duration<double, std::milli>(t21)
+                  << ", reduce cost: " << std::chrono::duration<double, std::milli>(t22)
+                  << ", map+reduce cost: " << std::chrono::duration<double, std::milli>(t21 + t22) << '\n';
+    }
+}
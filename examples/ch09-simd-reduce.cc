@@ -0,0 +1,39 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>  // std::plus
+#include <iostream>
+#include <numeric>  // std::reduce
+#include <string_view>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+// same number of bytes for every type
+template <typename T, typename R>
+void compare(std::string_view name, R const init) {
+    std::vector<T> v(4e8 / sizeof(T), T(3));
+    R s1{}, s2{}, s3{};
+
+    auto t1 = perf_timer<>::duration([&] { s1 = std::accumulate(std::begin(v), std::end(v), init); });
+    auto t2 = perf_timer<>::duration([&] { s2 = std::reduce(std::begin(v), std::end(v), init, std::plus<>()); });
+    auto t3 = perf_timer<>::duration([&] { s3 = ParallelUtils::simd::reduce(std::begin(v), std::end(v), init, std::plus<>()); });
+
+    std::cout << name << " accumulate: " << s1 << ", cost: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+    std::cout << name << "     reduce: " << s2 << ", cost: " << std::chrono::duration<double, std::milli>(t2) << '\n';
+    std::cout << name << "       simd: " << s3 << ", cost: " << std::chrono::duration<double, std::milli>(t3) << '\n';
+}
+
+int main() {
+    compare<unsigned char>(" uint8 ", 0LL);
+    compare<std::int16_t>(" int16 ", 0LL);
+    compare<std::uint32_t>("uint32 ", 0ULL);
+    compare<float>(" float ", 0.0);
+    compare<double>("double ", 0.0);
+
+    // parallel_reduce picks the kernel by itself for std::plus<>
+    std::vector<unsigned char> v(4e8, 1);
+    auto s = 0LL;
+    auto t = perf_timer<>::duration([&] { s = ParallelUtils::parallel_reduce(std::begin(v), std::end(v), 0LL, std::plus<>()); });
+    std::cout << "parallel_reduce: " << s << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+}
@@ -6,6 +6,8 @@
 #include <thread>
 #include <vector>
 
+#include "ch09-ParallelUtils.h"
+
 template <typename Time = std::chrono::microseconds,
           typename Clock = std::chrono::high_resolution_clock>
 struct perf_timer {
@@ -60,7 +62,7 @@ auto parallel_reduce(Iter begin, Iter end, R init, F op) {
         auto last = begin;
 
         std::vector<std::thread> threads;
-        std::vector<R> values(core_nums);
+        ParallelUtils::per_worker<R> values(core_nums);  // one cache line per thread
         for (unsigned i = 0; i < core_nums; ++i) {
             if (i == core_nums - 1)
                 last = end;
@@ -74,7 +76,7 @@ auto parallel_reduce(Iter begin, Iter end, R init, F op) {
 
         for (auto& t : threads) t.join();
 
-        return std::reduce(std::begin(values), std::end(values), init, std::forward<F>(op));
+        return values.combine(init, op);
     }
 }
 
@@ -0,0 +1,84 @@
+#include <algorithm>  // std::transform
+#include <chrono>
+#include <cmath>
+#include <functional>  // std::plus
+#include <iostream>
+#include <numeric>  // std::reduce
+#include <thread>
+#include <vector>
+
+#include "ch09-ParallelUtils.h"
+#include "PerfTimer.h"
+
+// equal chunks, one std::thread each: the slowest chunk decides the time
+template <typename Iter, typename F>
+void static_parallel_map(Iter begin, Iter end, F f) {
+    auto size = std::distance(begin, end);
+    auto core_nums = ParallelUtils::available_cpus();
+    auto part = size / core_nums;
+    auto last = begin;
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < core_nums; ++i) {
+        if (i == core_nums - 1)
+            last = end;
+        else
+            std::advance(last, part);
+
+        threads.emplace_back([=, &f] { std::transform(begin, last, begin, f); });
+
+        begin = last;
+    }
+
+    for (auto& t : threads) t.join();
+}
+
+// cost grows with the value, so the last chunk holds most of the work
+double skewed(double const x) {
+    auto r = x;
+    for (int i = 0, n = static_cast<int>(x); i < n; ++i) r = std::sqrt(r + i);
+    return r;
+}
+
+long long fib(int const n) {
+    if (n < 20) return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    long long a = 0, b = 0;
+    ParallelUtils::join([&] { a = fib(n - 1); }, [&] { b = fib(n - 2); });
+    return a + b;
+}
+
+int main() {
+    std::cout << "workers: " << ParallelUtils::thread_pool::instance().size() << '\n';
+
+    // example1: skewed element cost, static chunks vs work stealing
+    {
+        std::vector<double> v(20000);
+        std::iota(std::begin(v), std::end(v), 0.0);
+        auto v1 = v, v2 = v;
+
+        auto t1 = perf_timer<>::duration([&] { static_parallel_map(std::begin(v1), std::end(v1), skewed); });
+        auto t2 = perf_timer<>::duration([&] { ParallelUtils::parallel_map(std::begin(v2), std::end(v2), skewed); });
+        std::cout << "  static chunks: " << std::chrono::duration<double, std::milli>(t1) << '\n';
+        std::cout << "  work stealing: " << std::chrono::duration<double, std::milli>(t2)
+                  << ", same result: " << (v1 == v2) << '\n';
+    }
+    // example2: nested parallelism, a parallel_reduce per row inside a parallel_map over rows
+    {
+        std::vector<std::vector<int>> rows(64);
+        for (std::size_t i = 0; i < rows.size(); ++i) rows[i].assign(1000 * (i + 1), 1);
+        std::vector<long long> sums(rows.size());
+        std::iota(std::begin(sums), std::end(sums), 0);
+
+        ParallelUtils::parallel_map(std::begin(sums), std::end(sums), [&](long long const i) {
+            auto const& row = rows[i];
+            return ParallelUtils::parallel_reduce(std::begin(row), std::end(row), 0LL, std::plus<>());
+        }, 1);  // 64 rows is far below the default cutoff, grain 1 makes every row worth a task
+        std::cout << "nested sum: " << std::reduce(std::begin(sums), std::end(sums)) << '\n';  // 2080000
+    }
+    // example3: plain fork-join
+    {
+        long long r = 0;
+        auto t = perf_timer<>::duration([&] { r = fib(32); });
+        std::cout << "fib(32): " << r << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+}
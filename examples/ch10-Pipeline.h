@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>  // std::invoke
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>  // std::as_const
+
+#include "ch09-ParallelUtils.h"
+
+// Lazy pipelines in the style of ContainsProxy: src | map(f) | filter(p) | take(n) | reduce(op).
+// Nothing runs until the terminal stage (reduce, for_each) is attached. The stages are then fused into
+// one callable per element, a single loop over the source calls it, and no stage stores its output.
+// `| parallel()` runs the same fused loop on ParallelUtils::thread_pool, one loop per piece of the source.
+namespace Pipeline {
+
+// A stage wraps the callable of the stage after it. The callables return false to stop the loop.
+template <typename F>
+struct map_stage {
+    F f;
+
+    template <typename In>
+    using output = std::invoke_result_t<F const&, In>;
+
+    template <typename Next>
+    auto wrap(Next next) const {
+        return [f = f, next = std::move(next)](auto&& x) mutable { return next(std::invoke(f, std::forward<decltype(x)>(x))); };
+    }
+};
+
+template <typename P>
+struct filter_stage {
+    P p;
+
+    template <typename In>
+    using output = In;
+
+    template <typename Next>
+    auto wrap(Next next) const {
+        return [p = p, next = std::move(next)](auto&& x) mutable {
+            return std::invoke(p, std::as_const(x)) ? next(std::forward<decltype(x)>(x)) : true;
+        };
+    }
+};
+
+// the first n elements that reach it, so it keeps the loop in source order: sequential even under parallel()
+struct take_stage {
+    std::size_t n;
+
+    template <typename In>
+    using output = In;
+
+    template <typename Next>
+    auto wrap(Next next) const {
+        return [left = n, next = std::move(next)](auto&& x) mutable {
+            if (left == 0) return false;
+            --left;
+            return next(std::forward<decltype(x)>(x)) && left > 0;
+        };
+    }
+};
+
+struct parallel_stage {
+    std::size_t grain;
+};
+
+template <typename F>
+map_stage<F> map(F f) { return {std::move(f)}; }
+
+template <typename P>
+filter_stage<P> filter(P p) { return {std::move(p)}; }
+
+inline take_stage take(std::size_t const n) { return {n}; }
+
+// grain: fewest source elements worth a task of their own, as in ParallelUtils::parallel_map
+inline parallel_stage parallel(std::size_t const grain = 0) { return {grain}; }
+
+template <typename View, typename... Stages>
+struct pipeline {
+    View source;
+    std::tuple<Stages...> stages;
+    bool parallel = false;
+    std::size_t grain = 0;
+
+    static constexpr bool ordered = (std::is_same_v<Stages, take_stage> || ...);
+};
+
+// Terminals: attaching one runs the pipeline.
+struct no_init {};
+
+// op must be associative. reduce(init, op) gives init when nothing gets through the stages; reduce(op)
+// starts from the first element that does and gives a std::optional, empty then, like
+// std::ranges::fold_left_first. init is used once: under parallel() each piece starts from its own
+// first element, so op needs no identity
+template <typename T, typename Op>
+struct reduce_terminal {
+    T init;
+    Op op;
+};
+
+template <typename F>
+struct for_each_terminal {
+    F f;
+};
+
+template <typename Op>
+reduce_terminal<no_init, Op> reduce(Op op) { return {{}, std::move(op)}; }
+
+template <typename T, typename Op>
+reduce_terminal<T, Op> reduce(T init, Op op) { return {std::move(init), std::move(op)}; }
+
+// under parallel() f runs on several workers at once, in no particular order
+template <typename F>
+for_each_terminal<F> for_each(F f) { return {std::move(f)}; }
+
+namespace detail {
+    template <typename T>
+    struct is_pipeline : std::false_type {};
+    template <typename View, typename... Stages>
+    struct is_pipeline<pipeline<View, Stages...>> : std::true_type {};
+
+    template <typename T>
+    struct is_stage : std::false_type {};
+    template <typename F>
+    struct is_stage<map_stage<F>> : std::true_type {};
+    template <typename P>
+    struct is_stage<filter_stage<P>> : std::true_type {};
+    template <>
+    struct is_stage<take_stage> : std::true_type {};
+
+    template <typename T>
+    struct is_terminal : std::false_type {};
+    template <typename T, typename Op>
+    struct is_terminal<reduce_terminal<T, Op>> : std::true_type {};
+    template <typename F>
+    struct is_terminal<for_each_terminal<F>> : std::true_type {};
+
+    template <typename R>
+    concept source = std::ranges::viewable_range<R> && !is_pipeline<std::remove_cvref_t<R>>::value;
+
+    template <typename In, typename... Stages>
+    struct output_of {
+        using type = In;
+    };
+    template <typename In, typename S, typename... Rest>
+    struct output_of<In, S, Rest...> : output_of<typename S::template output<In>, Rest...> {};
+
+    // what the last stage passes to the terminal
+    template <typename P>
+    struct output;
+    template <typename View, typename... Stages>
+    struct output<pipeline<View, Stages...>> : output_of<std::ranges::range_reference_t<View>, Stages...> {};
+
+    // the last stage wraps the sink first, the first stage ends up outermost
+    template <std::size_t I, typename Tuple, typename Sink>
+    auto fuse(Tuple const& stages, Sink sink) {
+        if constexpr (I == 0)
+            return sink;
+        else
+            return fuse<I - 1>(stages, std::get<I - 1>(stages).wrap(std::move(sink)));
+    }
+
+    template <typename View, typename... Stages, typename Sink>
+    auto fuse(pipeline<View, Stages...> const& p, Sink sink) {
+        return fuse<sizeof...(Stages)>(p.stages, std::move(sink));
+    }
+
+    // the one loop every pipeline runs
+    template <typename It, typename Sentinel, typename Fused>
+    void loop(It first, Sentinel last, Fused& fused) {
+        for (; first != last; ++first)
+            if (!fused(*first)) break;
+    }
+
+    // whether the fused loop may run on the pool: asked for, order does not matter and pieces are cheap to find
+    template <typename View, typename... Stages>
+    bool on_pool(pipeline<View, Stages...> const& p, ParallelUtils::thread_pool& pool) {
+        if constexpr (pipeline<View, Stages...>::ordered || !std::ranges::random_access_range<View> ||
+                      !std::ranges::sized_range<View>)
+            return false;
+        else
+            return p.parallel && !pool.sequential(std::ranges::size(p.source), p.grain);
+    }
+}  // namespace detail
+
+template <detail::source R, typename S>
+    requires detail::is_stage<S>::value
+auto operator|(R&& r, S s) {
+    return pipeline<std::views::all_t<R>, S>{std::views::all(std::forward<R>(r)), {std::move(s)}};
+}
+
+template <typename View, typename... Stages, typename S>
+    requires detail::is_stage<S>::value
+auto operator|(pipeline<View, Stages...> p, S s) {
+    return pipeline<View, Stages..., S>{std::move(p.source), std::tuple_cat(std::move(p.stages), std::tuple<S>(std::move(s))),
+                                        p.parallel, p.grain};
+}
+
+template <detail::source R>
+auto operator|(R&& r, parallel_stage const s) {
+    return pipeline<std::views::all_t<R>>{std::views::all(std::forward<R>(r)), {}, true, s.grain};
+}
+
+template <typename View, typename... Stages>
+auto operator|(pipeline<View, Stages...> p, parallel_stage const s) {
+    p.parallel = true;
+    p.grain = s.grain;
+    return p;
+}
+
+template <typename View, typename... Stages, typename T, typename Op>
+auto operator|(pipeline<View, Stages...> p, reduce_terminal<T, Op> t) {
+    using P = pipeline<View, Stages...>;
+    constexpr bool first_as_init = std::is_same_v<T, no_init>;
+    using R = std::conditional_t<first_as_init, std::remove_cvref_t<typename detail::output<P>::type>, T>;
+    using result = std::conditional_t<first_as_init, std::optional<R>, R>;
+    // empty while nothing got through the stages
+    using partial = std::optional<R>;
+
+    auto& op = t.op;
+    auto fold_into = [&](partial& acc) {
+        return [&](auto&& x) {
+            if (acc)
+                *acc = op(std::move(*acc), std::forward<decltype(x)>(x));
+            else
+                acc.emplace(std::forward<decltype(x)>(x));
+            return true;
+        };
+    };
+
+    if constexpr (std::ranges::random_access_range<View> && std::ranges::sized_range<View>) {
+        auto& pool = ParallelUtils::thread_pool::current();
+        if (detail::on_pool(p, pool)) {
+            auto value = pool.template reduce_range<partial>(0, std::ranges::size(p.source), [&](std::size_t const lo, std::size_t const hi) {
+                partial acc;
+                auto fused = detail::fuse(p, fold_into(acc));
+                auto first = std::ranges::begin(p.source) + lo;
+                detail::loop(first, first + (hi - lo), fused);
+                return acc;
+            }, [&](partial a, partial b) -> partial {
+                if (!a) return b;
+                if (!b) return a;
+                return op(std::move(*a), std::move(*b));
+            }, p.grain);
+            if constexpr (first_as_init)
+                return result(std::move(value));
+            else
+                return value ? result(op(std::move(t.init), std::move(*value))) : result(std::move(t.init));
+        }
+    }
+
+    if constexpr (first_as_init) {
+        partial acc;
+        auto fused = detail::fuse(p, fold_into(acc));
+        detail::loop(std::ranges::begin(p.source), std::ranges::end(p.source), fused);
+        return result(std::move(acc));
+    } else {
+        // no check for a first element in the loop
+        R acc = std::move(t.init);
+        auto fused = detail::fuse(p, [&](auto&& x) { acc = op(std::move(acc), std::forward<decltype(x)>(x)); return true; });
+        detail::loop(std::ranges::begin(p.source), std::ranges::end(p.source), fused);
+        return result(std::move(acc));
+    }
+}
+
+template <typename View, typename... Stages, typename F>
+void operator|(pipeline<View, Stages...> p, for_each_terminal<F> t) {
+    auto call = [&](auto&& x) { std::invoke(t.f, std::forward<decltype(x)>(x)); return true; };
+
+    auto& pool = ParallelUtils::thread_pool::current();
+    if (!detail::on_pool(p, pool)) {
+        auto fused = detail::fuse(p, call);
+        detail::loop(std::ranges::begin(p.source), std::ranges::end(p.source), fused);
+        return;
+    }
+
+    if constexpr (std::ranges::random_access_range<View> && std::ranges::sized_range<View>)
+        pool.for_range(0, std::ranges::size(p.source), [&](std::size_t const lo, std::size_t const hi) {
+            auto fused = detail::fuse(p, call);
+            auto first = std::ranges::begin(p.source) + lo;
+            detail::loop(first, first + (hi - lo), fused);
+        }, p.grain);
+}
+
+// a source straight into a terminal
+template <detail::source R, typename T>
+    requires detail::is_terminal<T>::value
+auto operator|(R&& r, T t) {
+    return pipeline<std::views::all_t<R>>{std::views::all(std::forward<R>(r)), {}} | std::move(t);
+}
+
+}  // namespace Pipeline
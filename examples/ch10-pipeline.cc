@@ -0,0 +1,77 @@
+#include <algorithm>  // std::transform, std::copy_if, std::max
+#include <chrono>
+#include <functional>  // std::plus
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>  // std::accumulate
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "ch10-Pipeline.h"
+#include "PerfTimer.h"
+
+int main() {
+    std::vector<int> quantity(1e8);
+    {
+        std::mt19937 gen(3);
+        std::uniform_int_distribution<int> lots(-100, 100);  // negative: sells
+        for (auto& q : quantity) q = lots(gen) * 100;
+    }
+    auto notional = [](int const q) { return static_cast<long long>(q) * 25; };
+    auto is_buy = [](long long const n) { return n > 0; };
+
+    // example1: stages chained through temporary vectors
+    {
+        long long s0 = 0;
+        auto t = perf_timer<>::duration([&] {
+            std::vector<long long> mapped(quantity.size());
+            std::transform(std::begin(quantity), std::end(quantity), std::begin(mapped), notional);
+            std::vector<long long> buys;
+            std::copy_if(std::begin(mapped), std::end(mapped), std::back_inserter(buys), is_buy);
+            s0 = std::accumulate(std::begin(buys), std::end(buys), 0LL);
+        });
+        std::cout << "temporaries sum: " << s0 << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example2: the same stages fused into one loop
+    {
+        using namespace Pipeline;
+        long long s0 = 0;
+        auto t = perf_timer<>::duration([&] { s0 = quantity | map(notional) | filter(is_buy) | reduce(0LL, std::plus<>()); });
+        std::cout << "   pipeline sum: " << s0 << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example3: the fused loop on the thread pool
+    {
+        using namespace Pipeline;
+        long long s0 = 0;
+        auto t = perf_timer<>::duration([&] {
+            s0 = quantity | parallel() | map(notional) | filter(is_buy) | reduce(0LL, std::plus<>());
+        });
+        std::cout << "   parallel sum: " << s0 << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example4: take() stops the loop early, the rest of the source is never read
+    {
+        using namespace Pipeline;
+        long long s0 = 0;
+        auto t = perf_timer<>::duration([&] { s0 = (quantity | map(notional) | filter(is_buy) | take(10) | reduce(std::plus<>())).value_or(0); });
+        std::cout << " first 10 buys: " << s0 << ", cost: " << std::chrono::duration<double, std::milli>(t) << '\n';
+    }
+    // example5: an op without 0 as identity gives the same result in parallel, on a pool of 4 even on fewer cores
+    {
+        using namespace Pipeline;
+        auto is_sell = [](long long const n) { return n < 0; };
+        auto larger = [](long long const a, long long const b) { return std::max(a, b); };
+        auto const lowest = std::numeric_limits<long long>::lowest();
+        auto s0 = quantity | map(notional) | filter(is_sell) | reduce(lowest, larger);
+        long long s1 = 0;
+        std::optional<long long> s2;  // no init: the first sell, nothing at all if there is none
+        ParallelUtils::thread_pool pool(4);
+        pool.in_pool([&] {
+            s1 = quantity | parallel() | map(notional) | filter(is_sell) | reduce(lowest, larger);
+            s2 = quantity | parallel() | map(notional) | filter(is_sell) | reduce(larger);
+        });
+        std::cout << "smallest sell: " << s0 << ", parallel: " << s1 << ", without init: " << s2.value_or(0)
+                  << (s0 == s1 && s2 == s0 ? ", same" : ", DIFFERENT") << '\n';
+    }
+}